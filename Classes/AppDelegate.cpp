@@ -7,6 +7,11 @@
 #include "FacebookManager.h"
 #include "SoundManager.h"
 #include "AchievementManager.h"
+#include "CollisionBenchmark.h"
+#include "HazardSimulator.h"
+#include "GameScene.h"
+#include "ShipConfig.h"
+#include "WorldSnapshot.h"
 #include "audio/include/SimpleAudioEngine.h"
 
 #if CC_TARGET_PLATFORM == CC_PLATFORM_IOS
@@ -103,6 +108,17 @@ static int register_all_packages()
 }
 
 bool AppDelegate::applicationDidFinishLaunching() {
+    // These only touch the collision manager, so they run before there's a view
+#if COCOS2D_DEBUG > 0
+    // Every batch kernel is checked, not only the one selected for this device
+    int kernelMismatches = CollisionManager::verifyBatchKernels();
+    CCASSERT(kernelMismatches == 0, "The collision batch kernels disagree with the scalar tests!");
+#endif
+    
+#if COLLISION_BENCHMARK
+    CollisionBenchmark::run();
+#endif
+    
     // initialize director
     auto director = Director::getInstance();
     auto glview = director->getOpenGLView();
@@ -139,6 +155,11 @@ bool AppDelegate::applicationDidFinishLaunching() {
     // load the user programs
     loadCustomGLPrograms();
     
+#if HAZARD_SIMULATOR
+    // Balancing runs, before the title scene starts; see HazardSimulator.h for the parameters
+    HazardSimulator::log(HazardSimulator::run(HAZARD_SIMULATOR_SESSIONS, HAZARD_SIMULATOR_SESSION_TIME, HAZARD_SIMULATOR_SEED));
+#endif
+    
 #if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_WINRT
     director->getEventDispatcher()->addCustomEventListener(EVENT_RENDERER_RECREATED, [] (EventCustom*) { loadCustomGLPrograms(); rebuildBlurPrograms(); });
     
@@ -162,8 +183,20 @@ bool AppDelegate::applicationDidFinishLaunching() {
 
     register_all_packages();
 
-    // create a scene. it's an autorelease object
-    auto scene = createSceneWithLayer(MultiPurposeLayer::createTitleScene(BackgroundColor));
+    // create a scene. it's an autorelease object; a game the system closed while it was in the background
+    // goes on from where it was, paused, instead of the title
+    Scene *scene;
+    unsigned long snapshotShip;
+    
+    if (WorldSnapshot::peekShip(snapshotShip) && snapshotShip < getShipConfigSize())
+    {
+        global_ShipSelect = snapshotShip;
+        
+        auto gameScene = GameScene::create();
+        gameScene->resumeFromSnapshot();
+        scene = createSceneWithLayer(gameScene);
+    }
+    else scene = createSceneWithLayer(MultiPurposeLayer::createTitleScene(BackgroundColor));
     
     //if (!FacebookManager::hasPermission("user_friends"))
     //FacebookManager::requestReadPermissions();
@@ -19,6 +19,14 @@ bool BackgroundNode::init()
         return false;
     
     waitTime = 8;
+    
+    for (int i = 0; i < NumDepths; i++)
+    {
+        depthLayers[i] = Node::create();
+        addChild(depthLayers[i], i+1 - 18);
+        scrollOffsets[i] = 0;
+    }
+    
     scheduleUpdate();
     
     return true;
@@ -44,6 +52,12 @@ void BackgroundNode::onEnter()
 
 constexpr float MoveSpeedMin = 4, MoveSpeedMax = 12;
 
+// How much of the Advance speed each depth scrolls by; the farther ones (the lower depths) move less
+inline static float parallaxFactor(int depth)
+{
+    return 0.5f / (27 - depth);
+}
+
 static const Color3B backgroundColors[] = { 0xFFCC33_c3, 0xFF6666_c3, 0x999933_c3, 0xFF66CC_c3, 0x996666_c3 };
 constexpr int backgroundColorsSize = sizeof(backgroundColors)/sizeof(backgroundColors[0]);
 
@@ -56,12 +70,12 @@ void BackgroundNode::spawnBackground()
     
     auto node = Sprite::create("common/Background.png");
     if (!node->getTexture()->hasMipmaps()) node->getTexture()->generateMipmap();
-    node->setPosition(size.width + radius, size.height/2 + random(-.75*radius, .75*radius));
+    node->setPosition(size.width + radius + scrollOffsets[depth-1], size.height/2 + random(-.75*radius, .75*radius));
     node->setScale(2*radius/node->getContentSize().height);
     node->setColor(backgroundColors[random(0, backgroundColorsSize-1)]);
     node->setGLProgramState(GLProgramState::getOrCreateWithGLProgramName("BackgroundProgram"));
     node->setBlendFunc(BlendFunc::ALPHA_PREMULTIPLIED);
-    addChild(node, depth - 18);
+    depthLayers[depth-1]->addChild(node);
     
     float speed = 8 * random(MoveSpeedMin, MoveSpeedMax) / (9 - depth);
     float distance = size.width + 2*radius;
@@ -77,7 +91,26 @@ void BackgroundNode::update(float delta)
     waitTime -= delta * (1 + global_AdvanceSpeed/150);
     if (waitTime < 0) spawnBackground();
     
-    if (global_AdvanceSpeed > 0)
-        for (Node *node : getChildren())
-            node->setPositionX(node->getPositionX() - 0.5 * delta * global_AdvanceSpeed / (9 - node->getLocalZOrder()));
+    scrollLayers(delta);
+}
+
+void BackgroundNode::scrollLayers(float delta)
+{
+    for (int i = 0; i < NumDepths; i++)
+    {
+        if (global_AdvanceSpeed > 0)
+        {
+            scrollOffsets[i] += delta * global_AdvanceSpeed * parallaxFactor(i+1);
+            depthLayers[i]->setPositionX(-scrollOffsets[i]);
+        }
+        else if (scrollOffsets[i] != 0)
+        {
+            // Folded back into the sprites once the powerup is over, like HazardSelector does
+            for (Node *node : depthLayers[i]->getChildren())
+                node->setPositionX(node->getPositionX() - scrollOffsets[i]);
+            
+            scrollOffsets[i] = 0;
+            depthLayers[i]->setPositionX(0);
+        }
+    }
 }
\ No newline at end of file
@@ -13,7 +13,14 @@
 
 class BackgroundNode : public cocos2d::Node
 {
+    static constexpr int NumDepths = 8;
+    
+    // One layer per depth, scrolled as a whole by the Advance powerup at that depth's parallax factor
+    cocos2d::Node *depthLayers[NumDepths];
+    float scrollOffsets[NumDepths];
+    
     void spawnBackground();
+    void scrollLayers(float delta);
     float waitTime;
     
 public:
@@ -0,0 +1,212 @@
+//
+//  CollisionBenchmark.cpp
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#include "CollisionBenchmark.h"
+
+#if COLLISION_BENCHMARK
+
+#include "CollisionManager.h"
+#include "Defaults.h"
+#include <chrono>
+#include <atomic>
+#include <random>
+#include <cstdlib>
+
+using namespace cocos2d;
+
+static std::atomic<long> allocationCount(0);
+
+void *operator new(std::size_t size)
+{
+    allocationCount++;
+    if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+namespace CollisionBenchmark
+{
+    enum class Load { CubeWalls, FlameSwarms, Missiles };
+    
+    static const char *loadName(Load load)
+    {
+        switch (load)
+        {
+            case Load::CubeWalls: return "cube walls";
+            case Load::FlameSwarms: return "flame swarms";
+            case Load::Missiles: return "missiles";
+        }
+        return "";
+    }
+    
+    // The standard playfield on a 16:9 screen, unscaled, so world space is playfield space
+    static const Size PlayfieldSize(StandardPlayfieldHeight * 16/9, StandardPlayfieldHeight);
+    
+    // Same shape as the one in hazardMissileSpawner
+    static const Vec2 missilePoints[] =
+    {
+        { 18, 0 }, { -14, 7 }, { -15.65f, 6.7f }, { -16.85f, 5.55f }, { -17.5, 4 },
+        { -17.5, -4 }, { -16.85f, -5.55f }, { -15.65f, -6.7f }, { -14, -7 }
+    };
+    static constexpr int missilePointsSize = sizeof(missilePoints)/sizeof(missilePoints[0]);
+    
+    struct Mover
+    {
+        Node *node;
+        Vec2 velocity;
+        float angularVelocity;
+    };
+    
+    // Everything spawns over twice the playfield width, like hazards coming from offscreen, and wraps around
+    static void moveAll(std::vector<Mover> &movers, const Size &size, float delta)
+    {
+        for (auto &mover : movers)
+        {
+            auto position = mover.node->getPosition() + mover.velocity * delta;
+            if (position.x < -size.width/2) position.x += 2*size.width;
+            else if (position.x > 3*size.width/2) position.x -= 2*size.width;
+            if (position.y < 0) position.y += size.height;
+            else if (position.y > size.height) position.y -= size.height;
+            
+            mover.node->setPosition(position);
+            mover.node->setRotation(mover.node->getRotation() + mover.angularVelocity * delta);
+        }
+    }
+    
+    static void spawnHazards(Node *root, std::vector<Mover> &movers, Load load, int count, std::mt19937 &engine)
+    {
+        const Size &size = PlayfieldSize;
+        std::uniform_real_distribution<float> unit(0, 1);
+        CollisionManager::HazardCollisionData::HazardInfo info = { 30, 30, false, true, { nullptr, nullptr } };
+        
+        for (int i = 0; i < count; i++)
+        {
+            auto node = Node::create();
+            root->addChild(node);
+            
+            switch (load)
+            {
+                case Load::CubeWalls:
+                {
+                    // hazardCubeSpawner1: columns of cubes 48 units apart, moving left and spinning
+                    int perColumn = std::max(int(size.height/48), 1);
+                    node->setPosition(fmodf(size.width + 24 + (i / perColumn) * 96, 2*size.width) - size.width/2, (i % perColumn) * 48 + 24);
+                    movers.push_back({ node, Vec2(-112.5f, 0), 180 });
+                    CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircle(node, Vec2::ZERO, 20), info);
+                    break;
+                }
+                case Load::FlameSwarms:
+                {
+                    // hazardFireballSpawner: bursts of 8 flames flying apart from where the fireball exploded
+                    std::mt19937 burstEngine(i / 8);
+                    Vec2 center(2*size.width * unit(burstEngine) - size.width/2, size.height * unit(burstEngine));
+                    node->setPosition(center + Vec2::forAngle(2*M_PI * (i % 8) / 8) * 40 * unit(engine));
+                    movers.push_back({ node, Vec2::forAngle(2*M_PI * (i % 8) / 8) * 160, 0 });
+                    CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircle(node, Vec2::ZERO, 7.5), info);
+                    break;
+                }
+                case Load::Missiles:
+                {
+                    float angle = 2*M_PI * unit(engine);
+                    node->setPosition(2*size.width * unit(engine) - size.width/2, size.height * unit(engine));
+                    node->setRotation(-CC_RADIANS_TO_DEGREES(angle));
+                    movers.push_back({ node, Vec2::forAngle(angle) * 320, 45 });
+                    CollisionManager::addHazard(CollisionManager::HazardCollisionData::createPolygon(node, Vec2::ZERO, missilePoints, missilePointsSize), info);
+                    break;
+                }
+            }
+        }
+    }
+    
+    static void runCase(Load load, int hazardCount, int projectileCount, bool parallel)
+    {
+        const Size &size = PlayfieldSize;
+        std::mt19937 engine(hazardCount * 7 + projectileCount);
+        
+        RefPtr<Node> root = Node::create();
+        std::vector<Mover> movers;
+        
+        auto player = Node::create();
+        player->setPosition(size.width/4, size.height/2);
+        root->addChild(player);
+        CollisionManager::setPlayer(CollisionManager::PlayerCollisionData(player, Vec2::ZERO, 32 * PlayerScale,
+            [] (CollisionManager::HazardHandle, const CollisionManager::HazardCollisionData&, const CollisionManager::HazardCollisionData::HazardInfo&) {},
+            [] (CollisionManager::HazardHandle, const CollisionManager::HazardCollisionData&, const CollisionManager::HazardCollisionData::HazardInfo&) { return false; }));
+        
+        // The player shoots at 480 units/s; the projectiles never get spent, so the load stays the same
+        for (int i = 0; i < projectileCount; i++)
+        {
+            auto projectile = Node::create();
+            projectile->setPosition(size.width/4 + i * size.width/projectileCount, size.height/2);
+            root->addChild(projectile);
+            movers.push_back({ projectile, Vec2(480, 0), 0 });
+            CollisionManager::addProjectile(CollisionManager::ProjectileCollisionData(projectile, Vec2::ZERO, 10));
+        }
+        
+        spawnHazards(root, movers, load, hazardCount, engine);
+        CollisionManager::setParallelSweep(parallel);
+        
+        constexpr float Delta = 1.0f/60;
+        constexpr int WarmupTicks = 10;
+        int ticks = std::min(std::max(200000 / hazardCount, 20), 500);
+        
+        for (int i = 0; i < WarmupTicks; i++)
+        {
+            moveAll(movers, size, Delta);
+            CollisionManager::update();
+        }
+        
+        std::chrono::steady_clock::duration elapsed(0);
+        long allocations = 0;
+        for (int i = 0; i < ticks; i++)
+        {
+            moveAll(movers, size, Delta);
+            
+            long allocationsBefore = allocationCount;
+            auto start = std::chrono::steady_clock::now();
+            CollisionManager::update();
+            elapsed += std::chrono::steady_clock::now() - start;
+            allocations += allocationCount - allocationsBefore;
+        }
+        
+        double nsPerTick = std::chrono::duration<double, std::nano>(elapsed).count() / ticks;
+        double pairs = double(hazardCount) * (projectileCount + 1);
+        cocos2d::log("%-12s %6d hazards %d projectiles %-8s %10.1f us/tick %8.2f ns/pair %6.2f allocations/tick",
+              loadName(load), hazardCount, projectileCount, parallel ? "parallel" : "serial",
+              nsPerTick / 1000, nsPerTick / pairs, double(allocations) / ticks);
+        
+        CollisionManager::clearCollisionData();
+        root->removeAllChildren();
+    }
+    
+    void run()
+    {
+        cocos2d::log("Collision benchmark: playfield %g x %g", PlayfieldSize.width, PlayfieldSize.height);
+        CollisionManager::verifyBatchKernels();
+        CollisionManager::setPlayfieldHeight(PlayfieldSize.height);
+        
+        for (auto load : { Load::CubeWalls, Load::FlameSwarms, Load::Missiles })
+            for (int hazardCount : { 10, 100, 1000, 10000 })
+                for (int projectileCount : { 0, 1, 5 })
+                    for (bool parallel : { false, true })
+                        runCase(load, hazardCount, projectileCount, parallel);
+        
+        CollisionManager::setParallelSweep(true);
+    }
+}
+
+#endif
@@ -0,0 +1,22 @@
+//
+//  CollisionBenchmark.h
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#ifndef CollisionBenchmark_h
+#define CollisionBenchmark_h
+
+// Times CollisionManager::update() on synthetic loads shaped like the real spawners (cube walls, fireball
+// flame swarms, missiles), with 0, 1 and 5 player projectiles and 10 up to 10000 hazards, and logs the time
+// per pair and the allocations per tick, after checking every batch kernel (see CollisionManager::verifyBatchKernels).
+// Nothing is drawn, and neither a scene nor the Director's view is needed: it runs on a standard 16:9 playfield.
+// Only built when COLLISION_BENCHMARK is defined, because it replaces the global operator new to count allocations
+namespace CollisionBenchmark
+{
+    void run();
+}
+
+#endif /* CollisionBenchmark_h */
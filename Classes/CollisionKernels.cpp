@@ -0,0 +1,330 @@
+//
+//  CollisionKernels.cpp
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#include "CollisionKernels.h"
+#include <cfloat>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define USE_SSE2 1
+#include <emmintrin.h>
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define USE_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define USE_NEON 1
+#include <arm_neon.h>
+#if defined(__aarch64__) || defined(__arm64__)
+#define USE_NEON_DIVISION 1
+#endif
+#endif
+
+using namespace cocos2d;
+
+namespace CollisionKernels
+{
+    void CircleBatch::clear()
+    {
+        x.clear(); y.clear(); radius.clear(); ids.clear();
+        size = 0;
+    }
+    
+    void CircleBatch::push(const Vec2 &center, float radius, int id)
+    {
+        x.push_back(center.x); y.push_back(center.y);
+        this->radius.push_back(radius);
+        ids.push_back(id);
+        size++;
+    }
+    
+    // The padding lanes are placed so far away that their squared distance overflows, so they never hit
+    void CircleBatch::pad()
+    {
+        while (size % BatchWidth != 0)
+        {
+            push(Vec2(FLT_MAX, FLT_MAX), 0, -1);
+        }
+    }
+    
+    void CapsuleBatch::clear()
+    {
+        x1.clear(); y1.clear(); x2.clear(); y2.clear(); radius.clear(); ids.clear();
+        size = 0;
+    }
+    
+    void CapsuleBatch::push(const Vec2 &line1, const Vec2 &line2, float radius, int id)
+    {
+        x1.push_back(line1.x); y1.push_back(line1.y);
+        x2.push_back(line2.x); y2.push_back(line2.y);
+        this->radius.push_back(radius);
+        ids.push_back(id);
+        size++;
+    }
+    
+    void CapsuleBatch::pad()
+    {
+        while (size % BatchWidth != 0)
+        {
+            push(Vec2(FLT_MAX, FLT_MAX), Vec2(FLT_MAX, FLT_MAX), 0, -1);
+        }
+    }
+
+    // Scalar kernels: used when no vector instruction set is available, and always built so they can be
+    // checked too. The operations are laid out exactly as in the CollisionManager tests, and the vector
+    // kernels follow the same order
+    static uint32_t circleVsCirclesScalar(const Vec2 &center, float radius, const CircleBatch &batch, int first)
+    {
+        uint32_t mask = 0;
+        for (int i = 0; i < BatchWidth; i++)
+        {
+            float r = radius + batch.radius[first+i];
+            float dx = center.x - batch.x[first+i], dy = center.y - batch.y[first+i];
+            if (dx*dx + dy*dy <= r*r) mask |= 1u << i;
+        }
+        return mask;
+    }
+    
+    static uint32_t circleVsCapsulesScalar(const Vec2 &center, float radius, const CapsuleBatch &batch, int first)
+    {
+        uint32_t mask = 0;
+        for (int i = 0; i < BatchWidth; i++)
+        {
+            int j = first+i;
+            float r = radius + batch.radius[j];
+            float dx = batch.x2[j] - batch.x1[j], dy = batch.y2[j] - batch.y1[j];
+            float wx = center.x - batch.x1[j], wy = center.y - batch.y1[j];
+            float p2 = dx*dx + dy*dy;
+            float p = wx*dx + wy*dy;
+            
+            bool hit;
+            if (p < 0) hit = wx*wx + wy*wy < r*r;
+            else if (p > p2)
+            {
+                float ex = center.x - batch.x2[j], ey = center.y - batch.y2[j];
+                hit = ex*ex + ey*ey < r*r;
+            }
+            else
+            {
+                float px = batch.x1[j] + dx*p/p2 - center.x, py = batch.y1[j] + dy*p/p2 - center.y;
+                hit = px*px + py*py <= r*r;
+            }
+            
+            if (hit) mask |= 1u << i;
+        }
+        return mask;
+    }
+
+#if USE_SSE2
+    inline static int circlesSSE2(__m128 cx, __m128 cy, __m128 radius, const float *x, const float *y, const float *r)
+    {
+        __m128 rr = _mm_add_ps(radius, _mm_loadu_ps(r));
+        __m128 dx = _mm_sub_ps(cx, _mm_loadu_ps(x));
+        __m128 dy = _mm_sub_ps(cy, _mm_loadu_ps(y));
+        __m128 dist = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        return _mm_movemask_ps(_mm_cmple_ps(dist, _mm_mul_ps(rr, rr)));
+    }
+    
+    static uint32_t circleVsCirclesSSE2(const Vec2 &center, float radius, const CircleBatch &batch, int first)
+    {
+        __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), r = _mm_set1_ps(radius);
+        
+        int low = circlesSSE2(cx, cy, r, &batch.x[first], &batch.y[first], &batch.radius[first]);
+        int high = circlesSSE2(cx, cy, r, &batch.x[first+4], &batch.y[first+4], &batch.radius[first+4]);
+        return (uint32_t)(low | (high << 4));
+    }
+    
+    inline static __m128 selectSSE2(__m128 condition, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(condition, a), _mm_andnot_ps(condition, b));
+    }
+    
+    inline static int capsulesSSE2(__m128 cx, __m128 cy, __m128 radius, const CapsuleBatch &batch, int j)
+    {
+        __m128 x1 = _mm_loadu_ps(&batch.x1[j]), y1 = _mm_loadu_ps(&batch.y1[j]);
+        __m128 x2 = _mm_loadu_ps(&batch.x2[j]), y2 = _mm_loadu_ps(&batch.y2[j]);
+        __m128 rr = _mm_add_ps(radius, _mm_loadu_ps(&batch.radius[j]));
+        rr = _mm_mul_ps(rr, rr);
+        
+        __m128 dx = _mm_sub_ps(x2, x1), dy = _mm_sub_ps(y2, y1);
+        __m128 wx = _mm_sub_ps(cx, x1), wy = _mm_sub_ps(cy, y1);
+        __m128 p2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 p = _mm_add_ps(_mm_mul_ps(wx, dx), _mm_mul_ps(wy, dy));
+        
+        // Endpoint tests
+        __m128 hit1 = _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(wx, wx), _mm_mul_ps(wy, wy)), rr);
+        __m128 ex = _mm_sub_ps(cx, x2), ey = _mm_sub_ps(cy, y2);
+        __m128 hit2 = _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)), rr);
+        
+        // Distance test
+        __m128 px = _mm_sub_ps(_mm_add_ps(x1, _mm_div_ps(_mm_mul_ps(dx, p), p2)), cx);
+        __m128 py = _mm_sub_ps(_mm_add_ps(y1, _mm_div_ps(_mm_mul_ps(dy, p), p2)), cy);
+        __m128 hitMiddle = _mm_cmple_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), rr);
+        
+        __m128 hit = selectSSE2(_mm_cmplt_ps(p, _mm_setzero_ps()), hit1, selectSSE2(_mm_cmpgt_ps(p, p2), hit2, hitMiddle));
+        return _mm_movemask_ps(hit);
+    }
+    
+    static uint32_t circleVsCapsulesSSE2(const Vec2 &center, float radius, const CapsuleBatch &batch, int first)
+    {
+        __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), r = _mm_set1_ps(radius);
+        
+        int low = capsulesSSE2(cx, cy, r, batch, first);
+        int high = capsulesSSE2(cx, cy, r, batch, first+4);
+        return (uint32_t)(low | (high << 4));
+    }
+#endif
+
+#if USE_AVX2
+    // Compiled for AVX2 regardless of the global flags; only selected if the CPU reports support for it
+    __attribute__((target("avx2")))
+    static uint32_t circleVsCirclesAVX2(const Vec2 &center, float radius, const CircleBatch &batch, int first)
+    {
+        __m256 rr = _mm256_add_ps(_mm256_set1_ps(radius), _mm256_loadu_ps(&batch.radius[first]));
+        __m256 dx = _mm256_sub_ps(_mm256_set1_ps(center.x), _mm256_loadu_ps(&batch.x[first]));
+        __m256 dy = _mm256_sub_ps(_mm256_set1_ps(center.y), _mm256_loadu_ps(&batch.y[first]));
+        __m256 dist = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        return (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(dist, _mm256_mul_ps(rr, rr), _CMP_LE_OQ));
+    }
+    
+    __attribute__((target("avx2")))
+    static uint32_t circleVsCapsulesAVX2(const Vec2 &center, float radius, const CapsuleBatch &batch, int first)
+    {
+        __m256 cx = _mm256_set1_ps(center.x), cy = _mm256_set1_ps(center.y);
+        __m256 x1 = _mm256_loadu_ps(&batch.x1[first]), y1 = _mm256_loadu_ps(&batch.y1[first]);
+        __m256 x2 = _mm256_loadu_ps(&batch.x2[first]), y2 = _mm256_loadu_ps(&batch.y2[first]);
+        __m256 rr = _mm256_add_ps(_mm256_set1_ps(radius), _mm256_loadu_ps(&batch.radius[first]));
+        rr = _mm256_mul_ps(rr, rr);
+        
+        __m256 dx = _mm256_sub_ps(x2, x1), dy = _mm256_sub_ps(y2, y1);
+        __m256 wx = _mm256_sub_ps(cx, x1), wy = _mm256_sub_ps(cy, y1);
+        __m256 p2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 p = _mm256_add_ps(_mm256_mul_ps(wx, dx), _mm256_mul_ps(wy, dy));
+        
+        // Endpoint tests
+        __m256 hit1 = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(wx, wx), _mm256_mul_ps(wy, wy)), rr, _CMP_LT_OQ);
+        __m256 ex = _mm256_sub_ps(cx, x2), ey = _mm256_sub_ps(cy, y2);
+        __m256 hit2 = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(ex, ex), _mm256_mul_ps(ey, ey)), rr, _CMP_LT_OQ);
+        
+        // Distance test
+        __m256 px = _mm256_sub_ps(_mm256_add_ps(x1, _mm256_div_ps(_mm256_mul_ps(dx, p), p2)), cx);
+        __m256 py = _mm256_sub_ps(_mm256_add_ps(y1, _mm256_div_ps(_mm256_mul_ps(dy, p), p2)), cy);
+        __m256 hitMiddle = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(px, px), _mm256_mul_ps(py, py)), rr, _CMP_LE_OQ);
+        
+        __m256 hit = _mm256_blendv_ps(hitMiddle, hit2, _mm256_cmp_ps(p, p2, _CMP_GT_OQ));
+        hit = _mm256_blendv_ps(hit, hit1, _mm256_cmp_ps(p, _mm256_setzero_ps(), _CMP_LT_OQ));
+        return (uint32_t)_mm256_movemask_ps(hit);
+    }
+#endif
+
+#if USE_NEON
+    inline static uint32_t maskNEON(uint32x4_t hit)
+    {
+        static const uint32_t bitsData[4] = { 1, 2, 4, 8 };
+        uint32x4_t bits = vandq_u32(hit, vld1q_u32(bitsData));
+        uint32x2_t sum = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+        return vget_lane_u32(vpadd_u32(sum, sum), 0);
+    }
+    
+    inline static uint32_t circlesNEON(float32x4_t cx, float32x4_t cy, float32x4_t radius, const float *x, const float *y, const float *r)
+    {
+        float32x4_t rr = vaddq_f32(radius, vld1q_f32(r));
+        float32x4_t dx = vsubq_f32(cx, vld1q_f32(x));
+        float32x4_t dy = vsubq_f32(cy, vld1q_f32(y));
+        float32x4_t dist = vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy));
+        return maskNEON(vcleq_f32(dist, vmulq_f32(rr, rr)));
+    }
+    
+    static uint32_t circleVsCirclesNEON(const Vec2 &center, float radius, const CircleBatch &batch, int first)
+    {
+        float32x4_t cx = vdupq_n_f32(center.x), cy = vdupq_n_f32(center.y), r = vdupq_n_f32(radius);
+        
+        uint32_t low = circlesNEON(cx, cy, r, &batch.x[first], &batch.y[first], &batch.radius[first]);
+        uint32_t high = circlesNEON(cx, cy, r, &batch.x[first+4], &batch.y[first+4], &batch.radius[first+4]);
+        return low | (high << 4);
+    }
+    
+    inline static uint32_t capsulesNEON(float32x4_t cx, float32x4_t cy, float32x4_t radius, const CapsuleBatch &batch, int j)
+    {
+        float32x4_t x1 = vld1q_f32(&batch.x1[j]), y1 = vld1q_f32(&batch.y1[j]);
+        float32x4_t x2 = vld1q_f32(&batch.x2[j]), y2 = vld1q_f32(&batch.y2[j]);
+        float32x4_t rr = vaddq_f32(radius, vld1q_f32(&batch.radius[j]));
+        rr = vmulq_f32(rr, rr);
+        
+        float32x4_t dx = vsubq_f32(x2, x1), dy = vsubq_f32(y2, y1);
+        float32x4_t wx = vsubq_f32(cx, x1), wy = vsubq_f32(cy, y1);
+        float32x4_t p2 = vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy));
+        float32x4_t p = vaddq_f32(vmulq_f32(wx, dx), vmulq_f32(wy, dy));
+        
+        // Endpoint tests
+        uint32x4_t hit1 = vcltq_f32(vaddq_f32(vmulq_f32(wx, wx), vmulq_f32(wy, wy)), rr);
+        float32x4_t ex = vsubq_f32(cx, x2), ey = vsubq_f32(cy, y2);
+        uint32x4_t hit2 = vcltq_f32(vaddq_f32(vmulq_f32(ex, ex), vmulq_f32(ey, ey)), rr);
+        
+        // Distance test
+#if USE_NEON_DIVISION
+        float32x4_t px = vsubq_f32(vaddq_f32(x1, vdivq_f32(vmulq_f32(dx, p), p2)), cx);
+        float32x4_t py = vsubq_f32(vaddq_f32(y1, vdivq_f32(vmulq_f32(dy, p), p2)), cy);
+        uint32x4_t hitMiddle = vcleq_f32(vaddq_f32(vmulq_f32(px, px), vmulq_f32(py, py)), rr);
+#else
+        // ARMv7 has no vector division, so the distance test is scaled by p2 squared instead;
+        // a degenerate capsule (p2 == 0) must still miss, as the division would give NaN
+        float32x4_t px = vsubq_f32(vmulq_f32(dx, p), vmulq_f32(wx, p2));
+        float32x4_t py = vsubq_f32(vmulq_f32(dy, p), vmulq_f32(wy, p2));
+        uint32x4_t hitMiddle = vcleq_f32(vaddq_f32(vmulq_f32(px, px), vmulq_f32(py, py)), vmulq_f32(rr, vmulq_f32(p2, p2)));
+        hitMiddle = vandq_u32(hitMiddle, vcgtq_f32(p2, vdupq_n_f32(0)));
+#endif
+        
+        uint32x4_t hit = vbslq_u32(vcltq_f32(p, vdupq_n_f32(0)), hit1, vbslq_u32(vcgtq_f32(p, p2), hit2, hitMiddle));
+        return maskNEON(hit);
+    }
+    
+    static uint32_t circleVsCapsulesNEON(const Vec2 &center, float radius, const CapsuleBatch &batch, int first)
+    {
+        float32x4_t cx = vdupq_n_f32(center.x), cy = vdupq_n_f32(center.y), r = vdupq_n_f32(radius);
+        
+        uint32_t low = capsulesNEON(cx, cy, r, batch, first);
+        uint32_t high = capsulesNEON(cx, cy, r, batch, first+4);
+        return low | (high << 4);
+    }
+#endif
+    
+#if USE_AVX2
+    static bool hasAVX2()
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+    
+    const std::vector<KernelSet> &getAvailableKernels()
+    {
+        static const std::vector<KernelSet> kernels = []
+        {
+            std::vector<KernelSet> kernels { { "Scalar", circleVsCirclesScalar, circleVsCapsulesScalar } };
+#if USE_SSE2
+            kernels.push_back({ "SSE2", circleVsCirclesSSE2, circleVsCapsulesSSE2 });
+#endif
+#if USE_AVX2
+            if (hasAVX2()) kernels.push_back({ "AVX2", circleVsCirclesAVX2, circleVsCapsulesAVX2 });
+#endif
+#if USE_NEON
+            kernels.push_back({ "NEON", circleVsCirclesNEON, circleVsCapsulesNEON });
+#endif
+            return kernels;
+        }();
+        return kernels;
+    }
+    
+    CircleKernel circleVsCircles = getAvailableKernels().back().circles;
+    CapsuleKernel circleVsCapsules = getAvailableKernels().back().capsules;
+    
+    const char *getKernelName()
+    {
+        return getAvailableKernels().back().name;
+    }
+}
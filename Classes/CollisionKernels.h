@@ -0,0 +1,107 @@
+//
+//  CollisionKernels.h
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#ifndef CollisionKernels_h
+#define CollisionKernels_h
+
+#include <vector>
+#include <cstdint>
+#include "cocos2d.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace CollisionKernels
+{
+    // Every batch is padded to a multiple of this, and each kernel call tests one block of BatchWidth lanes
+    constexpr int BatchWidth = 8;
+    
+    // Structure-of-arrays storage for circles, so a block of them can be loaded straight into vector registers
+    struct CircleBatch
+    {
+        std::vector<float> x, y, radius;
+        std::vector<int> ids;
+        int size = 0;
+        
+        void clear();
+        void push(const cocos2d::Vec2 &center, float radius, int id);
+        void pad();
+    };
+    
+    struct CapsuleBatch
+    {
+        std::vector<float> x1, y1, x2, y2, radius;
+        std::vector<int> ids;
+        int size = 0;
+        
+        void clear();
+        void push(const cocos2d::Vec2 &line1, const cocos2d::Vec2 &line2, float radius, int id);
+        void pad();
+    };
+    
+    // Each kernel tests one circle against the BatchWidth lanes starting at 'first' and returns
+    // a bitmask with bit i set if lane first+i intersects it. They give the same answers as
+    // circleIntersection and capsuleCircleIntersection in CollisionManager.cpp
+    typedef uint32_t (*CircleKernel)(const cocos2d::Vec2 &center, float radius, const CircleBatch &batch, int first);
+    typedef uint32_t (*CapsuleKernel)(const cocos2d::Vec2 &center, float radius, const CapsuleBatch &batch, int first);
+    
+    struct KernelSet
+    {
+        const char *name;
+        CircleKernel circles;
+        CapsuleKernel capsules;
+    };
+    
+    // Every kernel set this build has and the CPU supports, from the scalar one to the one selected
+    const std::vector<KernelSet> &getAvailableKernels();
+    
+    extern CircleKernel circleVsCircles;
+    extern CapsuleKernel circleVsCapsules;
+    
+    // Name of the instruction set the kernels were selected for ("AVX2", "SSE2", "NEON" or "Scalar")
+    const char *getKernelName();
+    
+    inline int lowestBit(uint32_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (int)index;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+    
+    // Visit the ids of the lanes in [firstLane, lastLane) that intersect the circle; firstLane must be a multiple of BatchWidth
+    template <typename F> inline void forEachCircleHit(const cocos2d::Vec2 &center, float radius, const CircleBatch &batch, int firstLane, int lastLane, F func)
+    {
+        for (int first = firstLane; first < lastLane; first += BatchWidth)
+            for (uint32_t mask = circleVsCircles(center, radius, batch, first); mask; mask &= mask-1)
+                func(batch.ids[first + lowestBit(mask)]);
+    }
+    
+    template <typename F> inline void forEachCapsuleHit(const cocos2d::Vec2 &center, float radius, const CapsuleBatch &batch, int firstLane, int lastLane, F func)
+    {
+        for (int first = firstLane; first < lastLane; first += BatchWidth)
+            for (uint32_t mask = circleVsCapsules(center, radius, batch, first); mask; mask &= mask-1)
+                func(batch.ids[first + lowestBit(mask)]);
+    }
+    
+    template <typename F> inline void forEachCircleHit(const cocos2d::Vec2 &center, float radius, const CircleBatch &batch, F func)
+    {
+        forEachCircleHit(center, radius, batch, 0, batch.size, func);
+    }
+    
+    template <typename F> inline void forEachCapsuleHit(const cocos2d::Vec2 &center, float radius, const CapsuleBatch &batch, F func)
+    {
+        forEachCapsuleHit(center, radius, batch, 0, batch.size, func);
+    }
+}
+
+#endif /* CollisionKernels_h */
@@ -7,38 +7,126 @@
 //
 
 #include "CollisionManager.h"
+#include "Defaults.h"
+#include "CollisionKernels.h"
+#include "WorkerPool.h"
+#include <random>
 
 using namespace cocos2d;
 
 namespace CollisionManager
 {
     static PlayerCollisionData playerCollision;
-    static std::list<HazardCollisionData> hazardCollisions;
-    static std::list<PowerupCollisionData> powerupCollisions;
-    static std::list<ProjectileCollisionData> projectileCollisions;
+    static SlotMap<HazardCollisionData, HazardCollisionData::HazardInfo> hazardCollisions;
+    static SlotMap<PowerupCollisionData, PowerupDelegate> powerupCollisions;
+    static SlotMap<ProjectileCollisionData> projectileCollisions;
+    
+    // While update() is running, the dense arrays are being walked by index, so removals are queued
+    static bool updating = false;
+    static std::vector<HazardHandle> pendingHazardRemovals;
+    static std::vector<ProjectileHandle> pendingProjectileRemovals;
 
     void setPlayer(PlayerCollisionData &&collisionData)
     {
+        // Swapping the shape of the same node (e.g. for the shield) doesn't teleport it
+        LastPosition lastPosition;
+        if (playerCollision.positionNode == collisionData.positionNode && playerCollision.type == collisionData.type)
+            lastPosition = playerCollision.lastPosition;
+        
         playerCollision = std::move(collisionData);
+        playerCollision.lastPosition = lastPosition;
     }
 
-    void addHazard(HazardCollisionData &&collisionData)
+    HazardHandle addHazard(HazardCollisionData &&collisionData, const HazardCollisionData::HazardInfo &info)
     {
-        hazardCollisions.push_back(std::move(collisionData));
+        return hazardCollisions.insert(std::move(collisionData), info);
     }
 
-    void addPowerup(PowerupCollisionData &&collisionData)
+    PowerupHandle addPowerup(PowerupCollisionData &&collisionData, PowerupDelegate delegate)
+    {
+        return powerupCollisions.insert(std::move(collisionData), std::move(delegate));
+    }
+    
+    ProjectileHandle addProjectile(ProjectileCollisionData &&collisionData)
+    {
+        return projectileCollisions.insert(std::move(collisionData));
+    }
+    
+    void removeHazard(HazardHandle handle)
+    {
+        if (updating) pendingHazardRemovals.push_back(handle);
+        else hazardCollisions.erase(handle);
+    }
+    
+    void removePowerup(PowerupHandle handle)
     {
-        powerupCollisions.push_back(std::move(collisionData));
+        powerupCollisions.erase(handle);
+    }
+    
+    void removeProjectile(ProjectileHandle handle)
+    {
+        if (updating) pendingProjectileRemovals.push_back(handle);
+        else projectileCollisions.erase(handle);
+    }
+    
+    void destroyHazard(HazardHandle handle)
+    {
+        auto hazard = hazardCollisions.get(handle);
+        if (!hazard) return;
+        
+        if (hazard->type == CollisionType::CircleSet)
+        {
+            hazard->circleSet->removeCollisionCircle(hazard->hitCircle);
+            return;
+        }
+        
+        const auto &info = *hazardCollisions.getCold(handle);
+        hazard->positionNode->removeFromParentAndCleanup(true);
+        if (hazard->otherNode) hazard->otherNode->removeFromParentAndCleanup(true);
+        if (info.companionNode[0]) info.companionNode[0]->removeFromParent();
+        if (info.companionNode[1]) info.companionNode[1]->removeFromParent();
+        removeHazard(handle);
     }
     
-    void addProjectile(ProjectileCollisionData &&collisionData)
+    HazardCollisionData *getHazard(HazardHandle handle)
     {
-        projectileCollisions.push_back(std::move(collisionData));
+        return hazardCollisions.get(handle);
+    }
+    
+    HazardCollisionData::HazardInfo *getHazardInfo(HazardHandle handle)
+    {
+        return hazardCollisions.getCold(handle);
+    }
+    
+    int getHazardCount()
+    {
+        return (int)hazardCollisions.size();
     }
 
-    bool checkHazardCollisionCircle(const Vec2 &player, float playerRadius, const HazardCollisionData &hazard);
-    bool checkHazardCollisionPolygon(const Vec2 *playerList, int playerListSize, const HazardCollisionData &hazard);
+    // World-space shape of a collider, resolved once per tick by the snapshot stage of update().
+    // For polygons, position[0] and radius hold the bounding circle; for circle sets, position[0] is the
+    // origin of the set's node and the circles are in worldCircles. The motion is how much the shape
+    // moved since the previous tick (only translation is tracked), and the bounds cover the whole path
+    struct WorldShape
+    {
+        CollisionType type;
+        Vec2 position[2];
+        float radius;
+        Vec2 motion;
+        int vertexStart, vertexCount;
+        int pieceStart, pieceCount;
+        int circleStart, circleCount;
+        Rect bounds;
+    };
+    
+    // World-space convex piece of a polygon; its indices are relative to the polygon's vertexStart
+    struct WorldPiece
+    {
+        const int *indices;
+        int indexCount, normalStart;
+        Vec2 center;
+        float radius;
+    };
 
     inline bool circleIntersection(const Vec2 &shape1, float shape1radius, const Vec2 &shape2, float shape2radius)
     {
@@ -64,303 +152,921 @@ namespace CollisionManager
         return (pt - shape).lengthSquared() <= radius*radius;
     }
     
-    inline bool capsuleCapsuleIntersection(const Vec2 &line1_1, const Vec2 &line1_2, float line1Radius, const Vec2 &line2_1, const Vec2 &line2_2, float line2Radius)
+    // Affine part of a node's node-to-world transform, anchor point included, so a point
+    // in the node's space goes to world space the same way as with convertToWorldSpaceAR
+    struct WorldTransform
     {
-        // Try segment/segment first
-        if ((line2_1 - line1_1).cross(line1_2 - line1_1) * (line2_2 - line1_1).cross(line1_2 - line1_1) <= 0 &&
-            (line1_1 - line2_1).cross(line2_2 - line2_1) * (line1_2 - line2_1).cross(line2_2 - line1_1) <= 0) return true;
+        float a, b, c, d, tx, ty;
+        float scale, maxScale;
         
-        // We'll use the previous algorithm, for improvement
-        if (capsuleCircleIntersection(line1_1, line1Radius, line2_1, line2_2, line2Radius)) return true;
-        if (capsuleCircleIntersection(line1_2, line1Radius, line2_1, line2_2, line2Radius)) return true;
-        if (capsuleCircleIntersection(line2_1, line2Radius, line1_1, line1_2, line1Radius)) return true;
-        if (capsuleCircleIntersection(line2_2, line2Radius, line1_1, line1_2, line1Radius)) return true;
+        inline Vec2 apply(const Vec2 &point) const { return Vec2(a*point.x + c*point.y + tx, b*point.x + d*point.y + ty); }
         
-        return false;
+        // Normals go through the inverse transpose (here, the cofactor matrix, which only differs by a positive
+        // factor), flipped if the transform mirrors, so they still point outwards; they aren't renormalized
+        inline Vec2 applyNormal(const Vec2 &normal) const
+        {
+            float sign = a*d - b*c < 0 ? -1 : 1;
+            return Vec2(sign * (d*normal.x - b*normal.y), sign * (a*normal.y - c*normal.x));
+        }
+    };
+    
+    // Walks the parent chain once; the scale is taken from the matrix instead of multiplying
+    // the scales of every ancestor again
+    inline static WorldTransform resolveTransform(Node *node)
+    {
+        const Mat4 &m = node->getNodeToWorldTransform();
+        const Vec2 &anchor = node->getAnchorPointInPoints();
+        
+        WorldTransform transform;
+        transform.a = m.m[0]; transform.b = m.m[1];
+        transform.c = m.m[4]; transform.d = m.m[5];
+        transform.tx = m.m[12] + transform.a*anchor.x + transform.c*anchor.y;
+        transform.ty = m.m[13] + transform.b*anchor.x + transform.d*anchor.y;
+        transform.scale = sqrtf(transform.a*transform.a + transform.b*transform.b);
+        
+        // Largest singular value, so bounding circles stay conservative under non-uniform scales
+        float sum = transform.a*transform.a + transform.b*transform.b + transform.c*transform.c + transform.d*transform.d;
+        float det = transform.a*transform.d - transform.b*transform.c;
+        transform.maxScale = sqrtf((sum + sqrtf(std::max(sum*sum - 4*det*det, 0.0f)))/2);
+        return transform;
     }
-
-    inline bool polygonCircleIntersection(const Vec2 &shape, float shapeRadius, const Vec2 *pointList, int pointSize)
+    
+    inline static Rect circleBounds(const Vec2 &center, float radius)
+    {
+        return Rect(center.x - radius, center.y - radius, 2*radius, 2*radius);
+    }
+    
+    inline static Rect capsuleBounds(const Vec2 &line1, const Vec2 &line2, float radius)
     {
-        // Sanity check
-        if (pointSize < 3)
+        return circleBounds(line1, radius).unionWithRect(circleBounds(line2, radius));
+    }
+    
+    inline static Rect pointListBounds(const Vec2 *pointList, int pointSize)
+    {
+        Vec2 min = pointList[0], max = pointList[0];
+        for (int i = 1; i < pointSize; i++)
         {
-            CCLOG("Point list has less than 3 elements!");
-            return false;
+            min.x = std::min(min.x, pointList[i].x); min.y = std::min(min.y, pointList[i].y);
+            max.x = std::max(max.x, pointList[i].x); max.y = std::max(max.y, pointList[i].y);
         }
+        return Rect(min, Size(max - min));
+    }
+    
+    // Broadphase: a spatial hash over a uniform grid in world space. Cells are sized relative to the
+    // standard playfield height, so the grid has the same resolution regardless of the screen size
+    constexpr int GridCellsPerHeight = 8;
+    constexpr int GridBucketCount = 512;
+    
+    class SpatialGrid
+    {
+        float invCellSize;
+        std::vector<int> bucketStart, bucketFill, bucketItems;
+        std::vector<std::pair<int, int>> pendingItems;
         
-        bool insidePolygon = false;
+        // Hashed unsigned, so far-off and negative cells wrap around instead of overflowing
+        inline static int bucketFor(int x, int y) { return ((uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u) & (GridBucketCount-1); }
         
-        // We will simultaneoulsy conduct two tests
-        // Firstly, we have the "shell" test: just test intersection with the sides
-        // Second, we will test if the center is inside the polygon
-        for (int i = 0; i < pointSize; i++)
+        template <typename F> inline void forEachCell(const Rect &bounds, F func) const
         {
-            Vec2 point1 = pointList[i];
-            Vec2 point2 = pointList[(i+1)%pointSize];
+            int x0 = floorf(bounds.getMinX() * invCellSize), x1 = floorf(bounds.getMaxX() * invCellSize);
+            int y0 = floorf(bounds.getMinY() * invCellSize), y1 = floorf(bounds.getMaxY() * invCellSize);
             
-            // First test
-            if (point1 == point2) continue;
-            if (capsuleCircleIntersection(shape, shapeRadius, point1, point2, 0)) return true;
+            for (int y = y0; y <= y1; y++)
+                for (int x = x0; x <= x1; x++)
+                    func(bucketFor(x, y));
+        }
+        
+    public:
+        // What a query writes, kept apart so several threads can query the same grid at once
+        struct QueryState
+        {
+            std::vector<unsigned int> itemStamps;
+            unsigned int currentStamp = 0;
             
-            // Second test
-            if (point1.x < shape.x && point2.x < shape.x) continue;
-            if (point1.x < shape.x) point1 = point2 + (shape.x - point2.x) / (point1.x - point2.x) * (point1 - point2);
-            if (point2.x < shape.x) point2 = point1 + (shape.x - point1.x) / (point2.x - point1.x) * (point2 - point1);
+            inline void reset(int numItems) { itemStamps.assign(numItems, currentStamp); }
+        };
+        
+        void reset(float cellSize)
+        {
+            invCellSize = 1/cellSize;
+            pendingItems.clear();
+        }
+        
+        void insert(int item, const Rect &bounds)
+        {
+            forEachCell(bounds, [&] (int bucket) { pendingItems.emplace_back(bucket, item); });
+        }
+        
+        // Lay the items out contiguously per bucket (counting sort)
+        void build()
+        {
+            bucketStart.assign(GridBucketCount+1, 0);
+            for (const auto &pair : pendingItems) bucketStart[pair.first+1]++;
+            for (int i = 0; i < GridBucketCount; i++) bucketStart[i+1] += bucketStart[i];
             
-            if ((point1.y >= shape.y) != (point2.y >= shape.y)) insidePolygon = !insidePolygon;
+            bucketItems.resize(pendingItems.size());
+            bucketFill.assign(bucketStart.begin(), bucketStart.end()-1);
+            for (const auto &pair : pendingItems) bucketItems[bucketFill[pair.first]++] = pair.second;
         }
         
-        // Check if the second test is true
-        return insidePolygon;
+        // Calls func once for every item that shares a cell with the bounds (false positives are
+        // possible due to hash collisions, so the narrowphase must still be run)
+        template <typename F> void query(const Rect &bounds, QueryState &state, F func) const
+        {
+            state.currentStamp++;
+            forEachCell(bounds, [&] (int bucket)
+            {
+                for (int i = bucketStart[bucket]; i < bucketStart[bucket+1]; i++)
+                {
+                    int item = bucketItems[i];
+                    if (state.itemStamps[item] == state.currentStamp) continue;
+                    state.itemStamps[item] = state.currentStamp;
+                    func(item);
+                }
+            });
+        }
+    };
+    
+    static SpatialGrid hazardGrid;
+    static std::vector<bool> projectileAlive;
+    
+    // A hit found by the sweep, as dense indices of this tick (projectile is PlayerHit when the player was
+    // hit, part is the circle hit for circle sets). The indices stay valid while the events are resolved,
+    // since removals are deferred until the end
+    constexpr int PlayerHit = -1;
+    struct CollisionEvent
+    {
+        int hazard, projectile, part;
+        
+        // By hazard, in the order the hazards were added, then the projectiles, then the player
+        inline bool operator<(const CollisionEvent &other) const
+        {
+            if (hazard != other.hazard) return hazard < other.hazard;
+            return (unsigned)projectile < (unsigned)other.projectile;
+        }
+    };
+    static std::vector<CollisionEvent> collisionEvents;
+    
+    // Scratch state of one sweep thread, which only covers the hazards in [hazardBegin, hazardEnd)
+    // (and the batch lanes holding them); the sweep writes nowhere else
+    struct SweepContext
+    {
+        int hazardBegin, hazardEnd;
+        int circleBegin, circleEnd, capsuleBegin, capsuleEnd;
+        
+        SpatialGrid::QueryState gridState;
+        std::vector<int> candidateBuckets[5];
+        std::vector<std::pair<int, int>> queryHits;     // hazard and part, as in CollisionEvent
+        std::vector<CollisionEvent> events;
+        
+        inline bool covers(int hazard) const { return hazard >= hazardBegin && hazard < hazardEnd; }
+    };
+    static std::vector<SweepContext> sweepContexts;
+    
+    // Below this many hazards, waking the workers costs more than what they would take off the main thread
+    constexpr int ParallelSweepMinHazards = 48;
+    static bool parallelSweep = true;
+    
+    // Circle and capsule hazards, repacked from the snapshot for the batch kernels
+    static CollisionKernels::CircleBatch circleBatch;
+    static CollisionKernels::CapsuleBatch capsuleBatch;
+    static int circleCount, capsuleCount;
+    
+    // The per-tick snapshot: parallel to the dense arrays of the slot maps
+    static std::vector<WorldShape> hazardShapes, projectileShapes, powerupShapes;
+    static std::vector<Vec2> worldVertices, worldNormals;
+    static std::vector<WorldPiece> worldPieces;
+    static std::vector<WorldShape> worldCircles;
+    static WorldShape playerShape;
+    
+    inline static bool isHazardAlive(const HazardCollisionData &hazard)
+    {
+        return hazard.positionNode->getParent() != nullptr && (hazard.type != CollisionType::TwoNodeCapsule || hazard.otherNode->getParent() != nullptr);
     }
     
-    inline bool polygonCapsuleIntersection(const Vec2 &line1, const Vec2 &line2, float lineRadius, const Vec2 *pointList, int pointSize)
+    inline static WorldShape snapshotCircle(Node *node, const Vec2 &offset, float radius)
     {
-        // Sanity check
-        if (pointSize < 3)
+        auto transform = resolveTransform(node);
+        
+        WorldShape shape;
+        shape.type = CollisionType::Circle;
+        shape.motion = Vec2::ZERO;
+        shape.position[0] = transform.apply(offset);
+        shape.radius = radius * transform.scale;
+        shape.bounds = circleBounds(shape.position[0], shape.radius);
+        return shape;
+    }
+    
+    inline static WorldShape snapshotPolygon(Node *node, const PolygonShape *polygon)
+    {
+        auto transform = resolveTransform(node);
+        
+        WorldShape shape;
+        shape.type = CollisionType::Polygon;
+        shape.motion = Vec2::ZERO;
+        shape.position[0] = transform.apply(polygon->getCenter());
+        shape.radius = polygon->getBoundingRadius() * transform.maxScale;
+        
+        shape.vertexStart = (int)worldVertices.size();
+        shape.vertexCount = polygon->getVertexCount();
+        for (const auto &vertex : polygon->getVertices()) worldVertices.push_back(transform.apply(vertex));
+        
+        shape.pieceStart = (int)worldPieces.size();
+        shape.pieceCount = (int)polygon->getPieces().size();
+        int normalStart = (int)worldNormals.size();
+        for (const auto &normal : polygon->getPieceNormals()) worldNormals.push_back(transform.applyNormal(normal));
+        for (const auto &piece : polygon->getPieces())
         {
-            CCLOG("Point list has less than 3 elements!");
-            return false;
+            WorldPiece worldPiece;
+            worldPiece.indices = &polygon->getPieceIndices()[piece.indexStart];
+            worldPiece.indexCount = piece.indexCount;
+            worldPiece.normalStart = normalStart + piece.indexStart;
+            worldPiece.center = transform.apply(piece.center);
+            worldPiece.radius = piece.radius * transform.maxScale;
+            worldPieces.push_back(worldPiece);
         }
         
-        bool insidePolygon1 = false, insidePolygon2 = false;
+        shape.bounds = pointListBounds(&worldVertices[shape.vertexStart], shape.vertexCount);
+        return shape;
+    }
+    
+    static WorldShape snapshotHazard(const HazardCollisionData &hazardData)
+    {
+        switch (hazardData.type)
+        {
+            case CollisionType::Circle:
+                return snapshotCircle(hazardData.positionNode, hazardData.offset[0], hazardData.radius);
+            case CollisionType::TwoOffsetCapsule:
+            {
+                auto transform = resolveTransform(hazardData.positionNode);
+                
+                WorldShape shape;
+                shape.type = CollisionType::TwoOffsetCapsule;
+                shape.motion = Vec2::ZERO;
+                shape.position[0] = transform.apply(hazardData.offset[0]);
+                shape.position[1] = transform.apply(hazardData.offset[1]);
+                shape.radius = hazardData.radius * transform.scale;
+                shape.bounds = capsuleBounds(shape.position[0], shape.position[1], shape.radius);
+                return shape;
+            }
+            case CollisionType::TwoNodeCapsule:
+            {
+                auto transform1 = resolveTransform(hazardData.positionNode);
+                auto transform2 = resolveTransform(hazardData.otherNode);
+                
+                WorldShape shape;
+                shape.type = CollisionType::TwoNodeCapsule;
+                shape.motion = Vec2::ZERO;
+                shape.position[0] = transform1.apply(hazardData.offset[0]);
+                shape.position[1] = transform2.apply(hazardData.offset[0]);
+                shape.radius = hazardData.radius * std::min(transform1.scale, transform2.scale);
+                shape.bounds = capsuleBounds(shape.position[0], shape.position[1], shape.radius);
+                return shape;
+            }
+            case CollisionType::Polygon:
+                return snapshotPolygon(hazardData.positionNode, hazardData.polygon);
+            case CollisionType::CircleSet:
+            {
+                auto transform = resolveTransform(hazardData.positionNode);
+                
+                WorldShape shape;
+                shape.type = CollisionType::CircleSet;
+                shape.motion = Vec2::ZERO;
+                shape.position[0] = transform.apply(Vec2::ZERO);
+                shape.radius = 0;
+                shape.circleStart = (int)worldCircles.size();
+                
+                for (const auto &circle : hazardData.circleSet->getCollisionCircles())
+                {
+                    WorldShape part;
+                    part.type = CollisionType::Circle;
+                    part.position[0] = transform.apply(circle.position);
+                    part.radius = circle.radius * transform.scale;
+                    part.motion = transform.apply(circle.motion) - shape.position[0];
+                    worldCircles.push_back(part);
+                }
+                
+                shape.circleCount = (int)worldCircles.size() - shape.circleStart;
+                shape.bounds = Rect(shape.position[0], Size::ZERO);
+                return shape;
+            }
+        }
+    }
+    
+    // In world space; anything that moves farther than it in one tick was repositioned rather than moved there,
+    // so it isn't swept
+    static float playfieldHeight = StandardPlayfieldHeight;
+    
+    // Fills the shape's motion from where it was on the previous tick, and remembers where it is now. Capsules
+    // are tracked by their midpoint, polygons by their bounding center
+    static void trackMotion(WorldShape &shape, LastPosition &lastPosition)
+    {
+        Vec2 position = shape.type == CollisionType::TwoOffsetCapsule || shape.type == CollisionType::TwoNodeCapsule ?
+            (shape.position[0] + shape.position[1])/2 : shape.position[0];
         
-        // We will simultaneoulsy conduct two tests
-        // Firstly, we have the "shell" test: just test intersection with the sides
-        // Second, we will test if the any of the endpoints are inside the polygon
-        for (int i = 0; i < pointSize; i++)
+        if (lastPosition.valid && position.distanceSquared(lastPosition.position) <= playfieldHeight*playfieldHeight)
         {
-            auto point1 = pointList[i];
-            auto point2 = pointList[(i+1)%pointSize];
-            
-            // First test
-            if (point1 == point2) continue;
-            if (capsuleCapsuleIntersection(line1, line2, lineRadius, point1, point2, 0)) return true;
-            
-            // Second test
-            Vec2 point1c = point1, point2c = point2;
-            
-            if (point1.x < line1.x && point2.x < line1.x) continue;
-            if (point1.x < line1.x) point1 = point2 + (line1.x - point2.x) / (point1.x - point2.x) * (point1 - point2);
-            if (point2.x < line1.x) point2 = point1 + (line1.x - point1.x) / (point2.x - point1.x) * (point2 - point1);
-            if ((point1.y >= line1.y) != (point2.y >= line1.y)) insidePolygon1 = !insidePolygon1;
-            
-            if (point1c.x < line2.x && point2c.x < line2.x) continue;
-            if (point1c.x < line2.x) point1c = point2c + (line2.x - point2c.x) / (point1c.x - point2c.x) * (point1c - point2c);
-            if (point2c.x < line2.x) point2c = point1c + (line2.x - point1c.x) / (point2c.x - point1c.x) * (point2c - point1c);
-            if ((point1c.y >= line2.y) != (point2c.y >= line2.y)) insidePolygon2 = !insidePolygon2;
+            shape.motion = position - lastPosition.position;
+            shape.bounds = shape.bounds.unionWithRect(Rect(shape.bounds.origin - shape.motion, shape.bounds.size));
         }
         
-        // Check if the second test is true
-        return insidePolygon1 || insidePolygon2;
+        lastPosition.position = position;
+        lastPosition.valid = true;
     }
     
-    inline bool polygonPolygonIntersection(const Vec2 *pointList1, int pointSize1, const Vec2 *pointList2, int pointSize2)
+    // The circles of a set move along with its node, on top of their own motion; the set's bounds are
+    // only known after that
+    static void trackCircleSetMotion(WorldShape &shape)
     {
-        // Sanity check
-        if (pointSize1 < 3)
+        for (int i = 0; i < shape.circleCount; i++)
         {
-            CCLOG("Point list (1) has less than 3 elements!");
-            return false;
+            auto &circle = worldCircles[shape.circleStart + i];
+            circle.motion += shape.motion;
+            circle.bounds = circleBounds(circle.position[0], circle.radius);
+            circle.bounds = circle.bounds.unionWithRect(Rect(circle.bounds.origin - circle.motion, circle.bounds.size));
+            shape.bounds = i == 0 ? circle.bounds : shape.bounds.unionWithRect(circle.bounds);
         }
-        if (pointSize2 < 3)
+    }
+    
+    // Resolves every collider's world shape exactly once, dropping the entries whose nodes were detached
+    // without removing their handles. All the pair tests of this tick read from here
+    static void snapshotColliders()
+    {
+        worldVertices.clear();
+        worldNormals.clear();
+        worldPieces.clear();
+        worldCircles.clear();
+        
+        if (playerCollision.type == CollisionType::Polygon)
+            playerShape = snapshotPolygon(playerCollision.positionNode, playerCollision.polygon);
+        else playerShape = snapshotCircle(playerCollision.positionNode, playerCollision.offset, playerCollision.radius);
+        trackMotion(playerShape, playerCollision.lastPosition);
+        
+        hazardShapes.clear();
+        for (size_t i = 0; i < hazardCollisions.size();)
         {
-            CCLOG("Point list (2) has less than 3 elements!");
-            return false;
+            if (!isHazardAlive(hazardCollisions.hot(i))) hazardCollisions.eraseAt(i);
+            else
+            {
+                hazardShapes.push_back(snapshotHazard(hazardCollisions.hot(i)));
+                trackMotion(hazardShapes.back(), hazardCollisions.hot(i).lastPosition);
+                if (hazardShapes.back().type == CollisionType::CircleSet) trackCircleSetMotion(hazardShapes.back());
+                i++;
+            }
         }
         
-        // Iterate through each segment of each polygon
-        for (int i = 0; i < pointSize1; i++)
+        projectileShapes.clear();
+        for (size_t i = 0; i < projectileCollisions.size();)
         {
-            for (int j = 0; j < pointSize2; j++)
+            auto &data = projectileCollisions.hot(i);
+            if (data.positionNode->getParent() == nullptr) projectileCollisions.eraseAt(i);
+            else
             {
-                auto point1_1 = pointList1[i];
-                auto point1_2 = pointList1[(i+1)%pointSize1];
-                auto point2_1 = pointList2[j];
-                auto point2_2 = pointList2[(j+1)%pointSize2];
-                
-                if (point1_1 == point1_2 || point2_1 == point2_2) continue;
-                
-                // segment/segment intersection, better than capsule/segment intersection
-                if ((point2_1 - point1_1).cross(point1_2 - point1_1) * (point2_2 - point1_1).cross(point1_2 - point1_1) <= 0 &&
-                    (point1_1 - point2_1).cross(point2_2 - point2_1) * (point1_2 - point2_1).cross(point2_2 - point1_1) <= 0) return true;
+                projectileShapes.push_back(snapshotCircle(data.positionNode, data.offset, data.radius));
+                trackMotion(projectileShapes.back(), data.lastPosition);
+                i++;
             }
         }
         
-        // Nothing... ?
-        return false;
+        powerupShapes.clear();
+        for (size_t i = 0; i < powerupCollisions.size();)
+        {
+            const auto &data = powerupCollisions.hot(i);
+            if (data.positionNode->getParent() == nullptr) powerupCollisions.eraseAt(i);
+            else
+            {
+                powerupShapes.push_back(snapshotCircle(data.positionNode, data.offset, data.radius));
+                i++;
+            }
+        }
     }
     
-    Vec2 tempPlayerTransformStore[40], tempHazardTransformStore[32];
+    // Smallest circle holding a moving circle over the whole tick, for the broadphase
+    inline static void sweptCircleBounds(const Vec2 &center, float radius, const Vec2 &motion, Vec2 &boundsCenter, float &boundsRadius)
+    {
+        boundsCenter = center - motion/2;
+        boundsRadius = radius + motion.length()/2;
+    }
     
-    inline float combinedScale(Node* node)
+    // The batches hold the swept bounds of the hazards, so the kernels only cull; the hits are confirmed by the pair tests
+    static void packHazardBatches()
     {
-        float scale = 1;
-        while (node)
+        circleBatch.clear();
+        capsuleBatch.clear();
+        
+        for (int i = 0; i < (int)hazardShapes.size(); i++)
         {
-            scale *= node->getScale();
-            node = node->getParent();
+            const auto &shape = hazardShapes[i];
+            if (shape.type == CollisionType::Polygon || shape.type == CollisionType::CircleSet) continue;
+            
+            Vec2 center;
+            float radius;
+            sweptCircleBounds(shape.position[0], shape.radius, shape.motion, center, radius);
+            if (shape.type == CollisionType::Circle) circleBatch.push(center, radius, i);
+            else capsuleBatch.push(center, shape.position[1] - shape.motion/2, radius, i);
         }
-        return scale;
+        
+        circleCount = circleBatch.size;
+        capsuleCount = capsuleBatch.size;
+        circleBatch.pad();
+        capsuleBatch.pad();
     }
     
-    void update()
+    inline static const Vec2 *shapeVertices(const WorldShape &shape) { return &worldVertices[shape.vertexStart]; }
+    
+    // How the hazard moved over the tick as seen from the query. The swept tests hold one of the
+    // shapes still and move the other one along its whole path, which is exact for translations
+    inline static Vec2 relativeMotion(const WorldShape &query, const WorldShape &hazard) { return hazard.motion - query.motion; }
+    
+    inline static bool boundingCirclesIntersect(const Vec2 &center1, float radius1, const Vec2 &center2, float radius2)
     {
-        if (!playerCollision.positionNode) return;
+        return (center1 - center2).lengthSquared() <= (radius1 + radius2)*(radius1 + radius2);
+    }
+    
+    inline static float pointSegmentDistanceSquared(const Vec2 &point, const Vec2 &line1, const Vec2 &line2)
+    {
+        Vec2 edge = line2 - line1;
+        float length = edge.lengthSquared();
+        float t = length > 0 ? clampf((point - line1).dot(edge) / length, 0, 1) : 0;
+        return (line1 + edge*t - point).lengthSquared();
+    }
+    
+    // Zero if they cross; otherwise the closest pair involves an endpoint (collinear and degenerate segments included)
+    static float segmentSegmentDistanceSquared(const Vec2 &line1_1, const Vec2 &line1_2, const Vec2 &line2_1, const Vec2 &line2_2)
+    {
+        float side1 = (line1_2 - line1_1).cross(line2_1 - line1_1), side2 = (line1_2 - line1_1).cross(line2_2 - line1_1);
+        float side3 = (line2_2 - line2_1).cross(line1_1 - line2_1), side4 = (line2_2 - line2_1).cross(line1_2 - line2_1);
+        if (((side1 < 0 && side2 > 0) || (side1 > 0 && side2 < 0)) && ((side3 < 0 && side4 > 0) || (side3 > 0 && side4 < 0))) return 0;
         
-        if (playerCollision.positionNode->getParent() == nullptr)
+        return std::min(std::min(pointSegmentDistanceSquared(line1_1, line2_1, line2_2), pointSegmentDistanceSquared(line1_2, line2_1, line2_2)),
+                        std::min(pointSegmentDistanceSquared(line2_1, line1_1, line1_2), pointSegmentDistanceSquared(line2_2, line1_1, line1_2)));
+    }
+    
+    inline static bool insidePiece(const Vec2 &point, const Vec2 *vertices, const WorldPiece &piece)
+    {
+        for (int i = 0; i < piece.indexCount; i++)
+            if (worldNormals[piece.normalStart + i].dot(point - vertices[piece.indices[i]]) > 0) return false;
+        return true;
+    }
+    
+    // A loop is a small convex polygon given by its points, in any winding: a point (a circle), a segment
+    // (a capsule or a moving circle) or a quad (a moving capsule). Degenerate loops contain nothing
+    static bool insideLoop(const Vec2 &point, const Vec2 *loop, int loopCount)
+    {
+        if (loopCount < 3) return false;
+        
+        float area = 0;
+        bool positive = true, negative = true;
+        for (int i = 0; i < loopCount; i++)
         {
-            playerCollision.positionNode->release();
-            playerCollision.positionNode = nullptr;
-            return;
+            const Vec2 &point1 = loop[i], &point2 = loop[(i+1)%loopCount];
+            area += point1.cross(point2);
+            float side = (point2 - point1).cross(point - point1);
+            positive = positive && side >= 0;
+            negative = negative && side <= 0;
         }
         
-        for (auto it = projectileCollisions.cbegin(); it != projectileCollisions.cend();)
-            if (it->positionNode->getParent() == nullptr) it = projectileCollisions.erase(it);
-            else ++it;
+        return area != 0 && (area > 0 ? positive : negative);
+    }
+    
+    // Whether the polygon comes within radius of the loop: one of them has a point inside the other, or an edge of
+    // one is close enough to an edge of the other
+    static bool polygonLoopIntersection(const WorldShape &polygon, const Vec2 *loop, int loopCount, float radius)
+    {
+        Vec2 loopCenter = Vec2::ZERO;
+        for (int i = 0; i < loopCount; i++) loopCenter += loop[i];
+        loopCenter = loopCenter / loopCount;
         
-        auto player = playerCollision.positionNode->convertToWorldSpaceAR(playerCollision.offset);
-        auto playerRadius = playerCollision.radius * combinedScale(playerCollision.positionNode);
+        float loopRadius = 0;
+        for (int i = 0; i < loopCount; i++) loopRadius = std::max(loopRadius, loop[i].distanceSquared(loopCenter));
+        loopRadius = sqrtf(loopRadius) + radius;
         
-        if (playerCollision.type == CollisionType::Polygon)
-            for (int i = 0; i < playerCollision.polygonListSize; i++)
-                tempPlayerTransformStore[i] = playerCollision.positionNode->convertToWorldSpaceAR(playerCollision.polygonList[i]);
+        if (!boundingCirclesIntersect(loopCenter, loopRadius, polygon.position[0], polygon.radius)) return false;
         
-        for (auto it = hazardCollisions.cbegin(); it != hazardCollisions.cend();)
-            if (it->positionNode->getParent() == nullptr ||
-                (it->type == CollisionType::TwoNodeCapsule && it->otherNode->getParent() == nullptr))
-                it = hazardCollisions.erase(it);
-            else
+        auto vertices = shapeVertices(polygon);
+        int loopEdges = loopCount < 3 ? 1 : loopCount;
+        for (int i = polygon.pieceStart; i < polygon.pieceStart + polygon.pieceCount; i++)
+        {
+            const auto &piece = worldPieces[i];
+            if (!boundingCirclesIntersect(loopCenter, loopRadius, piece.center, piece.radius)) continue;
+            
+            if (insidePiece(loop[0], vertices, piece) || insideLoop(vertices[piece.indices[0]], loop, loopCount)) return true;
+            
+            for (int j = 0; j < piece.indexCount; j++)
             {
-                for (auto it2 = projectileCollisions.cbegin(); it2 != projectileCollisions.end();)
-                {
-                    auto projectile = it2->positionNode->convertToWorldSpaceAR(it2->offset);
-                    auto projectileRadius = it2->radius * combinedScale(it2->positionNode);
-                    
-                    if (checkHazardCollisionCircle(projectile, projectileRadius, *it))
-                    {
-                        // Custom optimization for projectiles only!
-                        if (playerCollision.projectileDelegate(*it))
-                        {
-                            it2->positionNode->removeFromParent();
-                            it2 = projectileCollisions.erase(it2);
-                        
-                            // The hazard should have been destroyed, so another good optimization
-                            goto outerContinue;
-                        }
-                        else ++it2;
-                    }
-                    else ++it2;
-                }
-                
-                // In order to the 'outerContinue' to function
-                {
-                    bool intersection = playerCollision.type == CollisionType::Polygon ?
-                        checkHazardCollisionPolygon(tempPlayerTransformStore, playerCollision.polygonListSize, *it) :
-                        checkHazardCollisionCircle(player, playerRadius, *it);
-                    
-                    if (intersection) playerCollision.delegate(*it);
-                }
-
-            outerContinue: ++it;
+                const Vec2 &point1 = vertices[piece.indices[j]];
+                const Vec2 &point2 = vertices[piece.indices[(j+1)%piece.indexCount]];
+                for (int k = 0; k < loopEdges; k++)
+                    if (segmentSegmentDistanceSquared(point1, point2, loop[k], loop[(k+1)%loopCount]) <= radius*radius)
+                        return true;
             }
+        }
         
-        for (auto it = powerupCollisions.cbegin(); it != powerupCollisions.cend();)
-            if (it->positionNode->getParent() == nullptr)
-                it = powerupCollisions.erase(it);
-            else
+        return false;
+    }
+    
+    inline static void projectPiece(const Vec2 *vertices, const WorldPiece &piece, const Vec2 &axis, float &min, float &max)
+    {
+        min = max = axis.dot(vertices[piece.indices[0]]);
+        for (int i = 1; i < piece.indexCount; i++)
+        {
+            float projection = axis.dot(vertices[piece.indices[i]]);
+            min = std::min(min, projection);
+            max = std::max(max, projection);
+        }
+    }
+    
+    // Separating axis test, with the second piece moving by sweep over the tick (so its projection is stretched)
+    inline static bool separatedOnAxis(const Vec2 &axis, const Vec2 *vertices1, const WorldPiece &piece1,
+                                       const Vec2 *vertices2, const WorldPiece &piece2, const Vec2 &sweep)
+    {
+        float min1, max1, min2, max2;
+        projectPiece(vertices1, piece1, axis, min1, max1);
+        projectPiece(vertices2, piece2, axis, min2, max2);
+        
+        float shift = axis.dot(sweep);
+        return max1 < min2 + std::min(shift, 0.0f) || max2 + std::max(shift, 0.0f) < min1;
+    }
+    
+    // On the edge normals of the first piece only
+    static bool separatedByNormals(const Vec2 *vertices1, const WorldPiece &piece1, const Vec2 *vertices2, const WorldPiece &piece2, const Vec2 &sweep)
+    {
+        for (int i = 0; i < piece1.indexCount; i++)
+            if (separatedOnAxis(worldNormals[piece1.normalStart + i], vertices1, piece1, vertices2, piece2, sweep)) return true;
+        return false;
+    }
+    
+    // The second polygon moves by motion over the tick. A swept convex piece is the hull of its start and end,
+    // whose edges are the piece's plus two parallel to the motion, so the motion's normal is the only extra axis
+    static bool polygonPolygonIntersection(const WorldShape &polygon1, const WorldShape &polygon2, const Vec2 &motion)
+    {
+        Vec2 sweptCenter;
+        float sweptRadius;
+        sweptCircleBounds(polygon2.position[0], polygon2.radius, motion, sweptCenter, sweptRadius);
+        if (!boundingCirclesIntersect(polygon1.position[0], polygon1.radius, sweptCenter, sweptRadius)) return false;
+        
+        float halfMotion = motion.length()/2;
+        Vec2 motionNormal(-motion.y, motion.x);
+        
+        auto vertices1 = shapeVertices(polygon1), vertices2 = shapeVertices(polygon2);
+        for (int i = polygon1.pieceStart; i < polygon1.pieceStart + polygon1.pieceCount; i++)
+        {
+            const auto &piece1 = worldPieces[i];
+            if (!boundingCirclesIntersect(piece1.center, piece1.radius, sweptCenter, sweptRadius)) continue;
+            
+            for (int j = polygon2.pieceStart; j < polygon2.pieceStart + polygon2.pieceCount; j++)
             {
-                auto powerup = it->positionNode->convertToWorldSpaceAR(it->offset);
-                auto powerupRadius = it->radius * combinedScale(it->positionNode);
-                
-                bool intersection = playerCollision.type == CollisionType::Polygon ?
-                    polygonCircleIntersection(powerup, powerupRadius, tempPlayerTransformStore, playerCollision.polygonListSize) :
-                    circleIntersection(player, playerRadius, powerup, powerupRadius);
+                const auto &piece2 = worldPieces[j];
+                if (!boundingCirclesIntersect(piece1.center, piece1.radius, piece2.center - motion/2, piece2.radius + halfMotion)) continue;
                 
-                if (intersection)
+                if (separatedByNormals(vertices1, piece1, vertices2, piece2, -motion)) continue;
+                if (separatedByNormals(vertices2, piece2, vertices1, piece1, motion)) continue;
+                if (halfMotion > 0 && separatedOnAxis(motionNormal, vertices1, piece1, vertices2, piece2, Vec2::ZERO)) continue;
+                return true;
+            }
+        }
+        
+        return false;
+    }
+    
+    // The pair tests, specialized at compile time for every (query shape, hazard shape) combination
+    // needed. Both capsule types have the same world-space form, so they share their tests. All of them
+    // are swept: a moving circle covers a capsule, a moving capsule covers a quad with round corners
+    template <CollisionType Query, CollisionType Hazard> struct PairTest;
+    
+    template <> struct PairTest<CollisionType::Circle, CollisionType::Circle>
+    {
+        inline static bool test(const WorldShape &query, const WorldShape &hazard)
+        {
+            auto motion = relativeMotion(query, hazard);
+            auto radius = query.radius + hazard.radius;
+            return pointSegmentDistanceSquared(query.position[0], hazard.position[0] - motion, hazard.position[0]) <= radius*radius;
+        }
+    };
+    
+    template <> struct PairTest<CollisionType::Circle, CollisionType::TwoOffsetCapsule>
+    {
+        inline static bool test(const WorldShape &query, const WorldShape &hazard)
+        {
+            auto motion = relativeMotion(query, hazard);
+            auto radius = query.radius + hazard.radius;
+            return segmentSegmentDistanceSquared(query.position[0] + motion, query.position[0], hazard.position[0], hazard.position[1]) <= radius*radius;
+        }
+    };
+    
+    template <> struct PairTest<CollisionType::Circle, CollisionType::TwoNodeCapsule> : PairTest<CollisionType::Circle, CollisionType::TwoOffsetCapsule> {};
+    
+    template <> struct PairTest<CollisionType::Circle, CollisionType::Polygon>
+    {
+        inline static bool test(const WorldShape &query, const WorldShape &hazard)
+        {
+            Vec2 path[] = { query.position[0] + relativeMotion(query, hazard), query.position[0] };
+            return polygonLoopIntersection(hazard, path, 2, query.radius);
+        }
+    };
+    
+    template <> struct PairTest<CollisionType::Polygon, CollisionType::Circle>
+    {
+        inline static bool test(const WorldShape &query, const WorldShape &hazard)
+        {
+            Vec2 path[] = { hazard.position[0] - relativeMotion(query, hazard), hazard.position[0] };
+            return polygonLoopIntersection(query, path, 2, hazard.radius);
+        }
+    };
+    
+    template <> struct PairTest<CollisionType::Polygon, CollisionType::TwoOffsetCapsule>
+    {
+        inline static bool test(const WorldShape &query, const WorldShape &hazard)
+        {
+            auto motion = relativeMotion(query, hazard);
+            Vec2 area[] = { hazard.position[0] - motion, hazard.position[1] - motion, hazard.position[1], hazard.position[0] };
+            return polygonLoopIntersection(query, area, 4, hazard.radius);
+        }
+    };
+    
+    template <> struct PairTest<CollisionType::Polygon, CollisionType::TwoNodeCapsule> : PairTest<CollisionType::Polygon, CollisionType::TwoOffsetCapsule> {};
+    
+    template <> struct PairTest<CollisionType::Polygon, CollisionType::Polygon>
+    {
+        inline static bool test(const WorldShape &query, const WorldShape &hazard)
+        {
+            return polygonPolygonIntersection(query, hazard, relativeMotion(query, hazard));
+        }
+    };
+    
+    // One loop per type pair, with the pair test inlined and no branch on the shape types
+    template <CollisionType Query, CollisionType Hazard> static void testBucket(SweepContext &context, const WorldShape &query)
+    {
+        for (int hazard : context.candidateBuckets[(int)Hazard])
+            if (PairTest<Query, Hazard>::test(query, hazardShapes[hazard])) context.queryHits.emplace_back(hazard, 0);
+    }
+    
+    // A set is hit through the first of its circles the query intersects
+    template <CollisionType Query> static void testCircleSetBucket(SweepContext &context, const WorldShape &query)
+    {
+        for (int hazard : context.candidateBuckets[(int)CollisionType::CircleSet])
+        {
+            const auto &set = hazardShapes[hazard];
+            for (int i = 0; i < set.circleCount; i++)
+                if (PairTest<Query, CollisionType::Circle>::test(query, worldCircles[set.circleStart + i]))
                 {
-                    // Custom optimization for powerups only!
-                    it->delegate(playerCollision);
-                    it = powerupCollisions.erase(it);
+                    context.queryHits.emplace_back(hazard, i);
+                    break;
                 }
-                else ++it;
-            }
+        }
     }
-
-    bool checkHazardCollisionCircle(const Vec2 &player, float playerRadius, const HazardCollisionData &hazardData)
+    
+    // Sorts the broadphase candidates of a query into one bucket per hazard type
+    static void gatherCandidates(SweepContext &context, const Rect &bounds)
     {
-        switch (hazardData.type)
+        for (auto &bucket : context.candidateBuckets) bucket.clear();
+        hazardGrid.query(bounds, context.gridState, [&] (int hazard)
         {
-            case CollisionType::Circle:
+            if (context.covers(hazard)) context.candidateBuckets[(int)hazardShapes[hazard].type].push_back(hazard);
+        });
+    }
+    
+    // Both fill the context's queryHits with every hazard (of its range) the query shape intersects
+    static void queryCircle(SweepContext &context, const WorldShape &circle)
+    {
+        context.queryHits.clear();
+        
+        Vec2 center;
+        float radius;
+        sweptCircleBounds(circle.position[0], circle.radius, circle.motion, center, radius);
+        CollisionKernels::forEachCircleHit(center, radius, circleBatch, context.circleBegin, context.circleEnd, [&] (int hazard)
+        {
+            if (context.covers(hazard) && PairTest<CollisionType::Circle, CollisionType::Circle>::test(circle, hazardShapes[hazard]))
+                context.queryHits.emplace_back(hazard, 0);
+        });
+        CollisionKernels::forEachCapsuleHit(center, radius, capsuleBatch, context.capsuleBegin, context.capsuleEnd, [&] (int hazard)
+        {
+            if (context.covers(hazard) && PairTest<CollisionType::Circle, CollisionType::TwoOffsetCapsule>::test(circle, hazardShapes[hazard]))
+                context.queryHits.emplace_back(hazard, 0);
+        });
+        
+        gatherCandidates(context, circle.bounds);
+        testBucket<CollisionType::Circle, CollisionType::Polygon>(context, circle);
+        testCircleSetBucket<CollisionType::Circle>(context, circle);
+    }
+    
+    static void queryPolygon(SweepContext &context, const WorldShape &polygon)
+    {
+        context.queryHits.clear();
+        gatherCandidates(context, polygon.bounds);
+        testBucket<CollisionType::Polygon, CollisionType::Circle>(context, polygon);
+        testBucket<CollisionType::Polygon, CollisionType::TwoOffsetCapsule>(context, polygon);
+        testBucket<CollisionType::Polygon, CollisionType::TwoNodeCapsule>(context, polygon);
+        testBucket<CollisionType::Polygon, CollisionType::Polygon>(context, polygon);
+        testCircleSetBucket<CollisionType::Polygon>(context, polygon);
+    }
+    
+    // Block-aligned range of the lanes whose ids (ascending, in the first 'count' lanes) are in [begin, end)
+    static void laneRange(const std::vector<int> &ids, int count, int begin, int end, int &firstLane, int &lastLane)
+    {
+        using CollisionKernels::BatchWidth;
+        firstLane = int(std::lower_bound(ids.begin(), ids.begin() + count, begin) - ids.begin()) / BatchWidth * BatchWidth;
+        lastLane = int(std::lower_bound(ids.begin(), ids.begin() + count, end) - ids.begin());
+        lastLane = (lastLane + BatchWidth - 1) / BatchWidth * BatchWidth;
+    }
+    
+    static void setupSweepContexts(int numContexts, int numHazards)
+    {
+        if ((int)sweepContexts.size() < numContexts) sweepContexts.resize(numContexts);
+        
+        for (int i = 0; i < numContexts; i++)
+        {
+            auto &context = sweepContexts[i];
+            context.hazardBegin = numHazards * i / numContexts;
+            context.hazardEnd = numHazards * (i+1) / numContexts;
+            laneRange(circleBatch.ids, circleCount, context.hazardBegin, context.hazardEnd, context.circleBegin, context.circleEnd);
+            laneRange(capsuleBatch.ids, capsuleCount, context.hazardBegin, context.hazardEnd, context.capsuleBegin, context.capsuleEnd);
+            context.gridState.reset(numHazards);
+        }
+    }
+    
+    // Runs every query of the tick against the context's hazards; only reads the snapshot
+    static void sweep(SweepContext &context)
+    {
+        context.events.clear();
+        for (int i = 0; i < (int)projectileShapes.size(); i++)
+        {
+            queryCircle(context, projectileShapes[i]);
+            for (const auto &hit : context.queryHits) context.events.push_back({ hit.first, i, hit.second });
+        }
+        
+        if (playerShape.type == CollisionType::Polygon) queryPolygon(context, playerShape);
+        else queryCircle(context, playerShape);
+        for (const auto &hit : context.queryHits) context.events.push_back({ hit.first, PlayerHit, hit.second });
+    }
+    
+    // Walk backwards, so erasing (which moves the last entry into the hole) doesn't disturb the snapshot indices
+    template <CollisionType Player> static void updatePowerups()
+    {
+        for (int i = (int)powerupCollisions.size()-1; i >= 0; i--)
+        {
+            if (PairTest<Player, CollisionType::Circle>::test(playerShape, powerupShapes[i]))
             {
-                auto hazard = hazardData.positionNode->convertToWorldSpaceAR(hazardData.offset[0]);
-                auto hazardRadius = hazardData.radius * combinedScale(hazardData.positionNode);
-                
-                return circleIntersection(player, playerRadius, hazard, hazardRadius);
+                // Custom optimization for powerups only!
+                auto delegate = std::move(powerupCollisions.cold(i));
+                powerupCollisions.eraseAt(i);
+                delegate(playerCollision);
             }
-            case CollisionType::TwoOffsetCapsule:
+        }
+    }
+    
+    void setPlayfieldHeight(float height)
+    {
+        playfieldHeight = height;
+    }
+    
+    int verifyBatchKernels()
+    {
+        using CollisionKernels::BatchWidth;
+        int totalMismatches = 0;
+        
+        for (const auto &kernels : CollisionKernels::getAvailableKernels())
+        {
+            std::mt19937 engine;
+            std::uniform_real_distribution<float> position(-100, 100), radius(0, 40);
+            CollisionKernels::CircleBatch circles;
+            CollisionKernels::CapsuleBatch capsules;
+            int mismatches = 0;
+            
+            for (int iteration = 0; iteration < 256; iteration++)
             {
-                auto hazard1 = hazardData.positionNode->convertToWorldSpaceAR(hazardData.offset[0]);
-                auto hazard2 = hazardData.positionNode->convertToWorldSpaceAR(hazardData.offset[1]);
-                auto hazardRadius = hazardData.radius * combinedScale(hazardData.positionNode);
+                // 13 shapes, so the padding lanes are exercised too, plus a degenerate capsule
+                circles.clear();
+                capsules.clear();
+                for (int i = 0; i < 13; i++)
+                {
+                    circles.push(Vec2(position(engine), position(engine)), radius(engine), i);
+                    capsules.push(Vec2(position(engine), position(engine)), Vec2(position(engine), position(engine)), radius(engine), i);
+                }
+                capsules.push(Vec2(10, 10), Vec2(10, 10), radius(engine), 13);
+                circles.pad();
+                capsules.pad();
                 
-                return capsuleCircleIntersection(player, playerRadius, hazard1, hazard2, hazardRadius);
-            }
-            case CollisionType::TwoNodeCapsule:
-            {
-                auto hazard1 = hazardData.positionNode->convertToWorldSpaceAR(hazardData.offset[0]);
-                auto hazard2 = hazardData.otherNode->convertToWorldSpaceAR(hazardData.offset[0]);
-                auto minScale = std::min(combinedScale(hazardData.positionNode), combinedScale(hazardData.otherNode));
-                auto hazardRadius = hazardData.radius * minScale;
+                Vec2 center(position(engine), position(engine));
+                float centerRadius = radius(engine);
                 
-                return capsuleCircleIntersection(player, playerRadius, hazard1, hazard2, hazardRadius);
-            }
-            case CollisionType::Polygon:
-            {
-                auto playerLocal = hazardData.positionNode->convertToNodeSpaceAR(player);
-                auto playerLocalRadius = playerRadius / combinedScale(hazardData.positionNode);
+                // The padding lanes (id -1) must never hit
+                for (int first = 0; first < circles.size; first += BatchWidth)
+                {
+                    uint32_t mask = kernels.circles(center, centerRadius, circles, first);
+                    for (int i = first; i < first + BatchWidth; i++)
+                    {
+                        bool expected = circles.ids[i] >= 0 && circleIntersection(center, centerRadius, Vec2(circles.x[i], circles.y[i]), circles.radius[i]);
+                        if (bool(mask & (1u << (i - first))) != expected) mismatches++;
+                    }
+                }
                 
-                return polygonCircleIntersection(playerLocal, playerLocalRadius, hazardData.polygonList, hazardData.polygonListSize);
+                for (int first = 0; first < capsules.size; first += BatchWidth)
+                {
+                    uint32_t mask = kernels.capsules(center, centerRadius, capsules, first);
+                    for (int i = first; i < first + BatchWidth; i++)
+                    {
+                        bool expected = capsules.ids[i] >= 0 && capsuleCircleIntersection(center, centerRadius, Vec2(capsules.x1[i], capsules.y1[i]),
+                                                                                          Vec2(capsules.x2[i], capsules.y2[i]), capsules.radius[i]);
+                        if (bool(mask & (1u << (i - first))) != expected) mismatches++;
+                    }
+                }
             }
+            
+            cocos2d::log("Collision batch kernels: %s, %d mismatches", kernels.name, mismatches);
+            totalMismatches += mismatches;
         }
+        
+        return totalMismatches;
     }
     
-    bool checkHazardCollisionPolygon(const Vec2 *playerList, int playerListSize, const HazardCollisionData &hazardData)
+    void update()
     {
-        switch (hazardData.type)
+        if (!playerCollision.positionNode) return;
+        
+        if (playerCollision.positionNode->getParent() == nullptr)
         {
-            case CollisionType::Circle:
-            {
-                auto hazard = hazardData.positionNode->convertToWorldSpaceAR(hazardData.offset[0]);
-                auto hazardRadius = hazardData.radius * combinedScale(hazardData.positionNode);
-                
-                return polygonCircleIntersection(hazard, hazardRadius, playerList, playerListSize);
-            }
-            case CollisionType::TwoOffsetCapsule:
-            {
-                auto hazard1 = hazardData.positionNode->convertToWorldSpaceAR(hazardData.offset[0]);
-                auto hazard2 = hazardData.positionNode->convertToWorldSpaceAR(hazardData.offset[1]);
-                auto hazardRadius = hazardData.radius * combinedScale(hazardData.positionNode);
-                
-                return polygonCapsuleIntersection(hazard1, hazard2, hazardRadius, playerList, playerListSize);
-            }
-            case CollisionType::TwoNodeCapsule:
+            playerCollision.positionNode->release();
+            playerCollision.positionNode = nullptr;
+            return;
+        }
+        
+        snapshotColliders();
+        packHazardBatches();
+        
+        updating = true;
+        
+        // Build the broadphase; circles and capsules only need to be in it if the player is a polygon,
+        // since every other query is a circle and those are tested by the batch kernels. Polygons and
+        // circle sets are always in it
+        int numHazards = (int)hazardCollisions.size();
+        bool playerIsPolygon = playerShape.type == CollisionType::Polygon;
+        hazardGrid.reset(playfieldHeight / GridCellsPerHeight);
+        for (int i = 0; i < numHazards; i++)
+            if (playerIsPolygon || hazardShapes[i].type == CollisionType::Polygon || hazardShapes[i].type == CollisionType::CircleSet)
+                hazardGrid.insert(i, hazardShapes[i].bounds);
+        hazardGrid.build();
+        
+        // Sweep: only gathers the hits, nothing outside the collision data is touched here. Big
+        // scenes are split in hazard ranges over the worker pool, each with its own hit buffer
+        int numContexts = 1;
+        if (parallelSweep && numHazards >= ParallelSweepMinHazards)
+            numContexts = WorkerPool::getInstance().getWorkerCount() + 1;
+        
+        setupSweepContexts(numContexts, numHazards);
+        if (numContexts > 1) WorkerPool::getInstance().parallelFor(numContexts, [] (int i) { sweep(sweepContexts[i]); });
+        else sweep(sweepContexts[0]);
+        
+        collisionEvents.clear();
+        for (int i = 0; i < numContexts; i++)
+            collisionEvents.insert(collisionEvents.end(), sweepContexts[i].events.begin(), sweepContexts[i].events.end());
+        std::sort(collisionEvents.begin(), collisionEvents.end());
+        
+        // Resolve the hits in one pass. A hazard destroyed by a projectile takes no further hits
+        // on this tick (a circle set only loses the circle), and a projectile is spent on the first hazard that takes it
+        projectileAlive.assign(projectileCollisions.size(), true);
+        int spentHazard = -1;
+        
+        for (const auto &event : collisionEvents)
+        {
+            if (event.hazard == spentHazard) continue;
+            
+            auto &hazard = hazardCollisions.hot(event.hazard);
+            const auto &info = hazardCollisions.cold(event.hazard);
+            auto handle = hazardCollisions.handleAt(event.hazard);
+            
+            // A delegate may have removed this hazard's nodes earlier on this same tick (e.g. as a companion)
+            if (!isHazardAlive(hazard))
             {
-                auto hazard1 = hazardData.positionNode->convertToWorldSpaceAR(hazardData.offset[0]);
-                auto hazard2 = hazardData.otherNode->convertToWorldSpaceAR(hazardData.offset[0]);
-                auto minScale = std::min(combinedScale(hazardData.positionNode), combinedScale(hazardData.otherNode));
-                auto hazardRadius = hazardData.radius * minScale;
-                
-                return polygonCapsuleIntersection(hazard1, hazard2, hazardRadius, playerList, playerListSize);
+                pendingHazardRemovals.push_back(handle);
+                spentHazard = event.hazard;
+                continue;
             }
-            case CollisionType::Polygon:
+            
+            hazard.hitCircle = event.part;
+            if (event.projectile == PlayerHit) playerCollision.delegate(handle, hazard, info);
+            else if (projectileAlive[event.projectile] && playerCollision.projectileDelegate(handle, hazard, info))
             {
-                for (int i = 0; i < hazardData.polygonListSize; i++)
-                    tempHazardTransformStore[i] = hazardData.positionNode->convertToWorldSpaceAR(hazardData.polygonList[i]);
-                
-                return polygonPolygonIntersection(playerList, playerListSize, tempHazardTransformStore, hazardData.polygonListSize);
+                projectileCollisions.hot(event.projectile).positionNode->removeFromParent();
+                pendingProjectileRemovals.push_back(projectileCollisions.handleAt(event.projectile));
+                projectileAlive[event.projectile] = false;
+                if (hazard.type != CollisionType::CircleSet) spentHazard = event.hazard;
             }
         }
+        
+        updating = false;
+        for (auto handle : pendingHazardRemovals) hazardCollisions.erase(handle);
+        for (auto handle : pendingProjectileRemovals) projectileCollisions.erase(handle);
+        pendingHazardRemovals.clear();
+        pendingProjectileRemovals.clear();
+        
+        if (playerIsPolygon) updatePowerups<CollisionType::Polygon>();
+        else updatePowerups<CollisionType::Circle>();
+    }
+    
+    void setParallelSweep(bool enabled)
+    {
+        parallelSweep = enabled;
     }
     
     void clearCollisionData()
@@ -368,5 +1074,7 @@ namespace CollisionManager
         hazardCollisions.clear();
         powerupCollisions.clear();
         projectileCollisions.clear();
+        pendingHazardRemovals.clear();
+        pendingProjectileRemovals.clear();
     }
 }
\ No newline at end of file
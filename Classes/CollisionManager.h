@@ -10,6 +10,8 @@
 #define __SpaceExplorer__CollisionManager__
 
 #include "cocos2d.h"
+#include "SlotMap.h"
+#include "PolygonShape.h"
 
 class PlayerNode;
 
@@ -17,9 +19,38 @@ namespace CollisionManager
 {
     enum class CollisionType : int
     {
-        Circle, TwoOffsetCapsule, TwoNodeCapsule, Polygon
+        Circle, TwoOffsetCapsule, TwoNodeCapsule, Polygon, CircleSet
     };
     
+    // Where a collider was on the previous collision tick, in world space; update() keeps it so the
+    // sweep can test the whole path covered since then, instead of only the current position
+    struct LastPosition
+    {
+        cocos2d::Vec2 position;
+        bool valid = false;
+    };
+    
+    // A group of circles collided as a single hazard, for hazards made of many small parts (like a flame
+    // trail) that would otherwise need one each. The circles are in the space of the hazard's positionNode,
+    // and their motion is how far each of them moved there since the previous tick
+    class CircleSet
+    {
+    public:
+        struct Circle
+        {
+            cocos2d::Vec2 position, motion;
+            float radius;
+        };
+        
+        virtual ~CircleSet() {}
+        virtual const std::vector<Circle> &getCollisionCircles() const = 0;
+        
+        // Called by destroyHazard instead of removing the hazard; the other circles must keep their indices until the tick ends
+        virtual void removeCollisionCircle(int index) = 0;
+    };
+    
+    // Hot part of a hazard: everything the collision sweep reads on every tick. The gameplay info
+    // is only needed when a collision happens, so it's stored apart (see addHazard)
     struct HazardCollisionData
     {
         struct HazardInfo
@@ -32,35 +63,64 @@ namespace CollisionManager
         };
         
         CollisionType type;
-        HazardInfo info;
         cocos2d::Node *positionNode = nullptr;
         cocos2d::Node *otherNode = nullptr;
         
         cocos2d::Vec2 offset[2];
         float radius;
         
-        const cocos2d::Vec2* polygonList = nullptr;
-        int polygonListSize; bool copyList = false;
+        PolygonShape *polygon = nullptr;
+        
+        // Not retained: it must live as long as the positionNode (usually, it is the node)
+        CircleSet *circleSet = nullptr;
+        int hitCircle = 0;      // which circle of the set the hit being resolved landed on
+        
+        LastPosition lastPosition;
         
     private:
-        HazardCollisionData() : otherNode(nullptr), polygonList(nullptr), copyList(false) {}
+        HazardCollisionData() : otherNode(nullptr), polygon(nullptr) {}
+        
+        inline void releaseResources()
+        {
+            if (positionNode) positionNode->release();
+            if (otherNode) otherNode->release();
+            if (polygon) polygon->release();
+        }
         
     public:
         HazardCollisionData(HazardCollisionData &&other)
         : type(other.type), positionNode(other.positionNode), otherNode(other.otherNode), offset{other.offset[0], other.offset[1]},
-        radius(other.radius), polygonList(other.polygonList), polygonListSize(other.polygonListSize), info(other.info), copyList(other.copyList)
+        radius(other.radius), polygon(other.polygon), circleSet(other.circleSet), hitCircle(other.hitCircle), lastPosition(other.lastPosition)
         {
             other.positionNode = nullptr;
             other.otherNode = nullptr;
+            other.polygon = nullptr;
+        }
+        
+        HazardCollisionData &operator=(HazardCollisionData &&other)
+        {
+            if (this == &other) return *this;
+            releaseResources();
             
-            if (copyList)
-            {
-                other.polygonList = nullptr;
-                other.copyList = false;
-            }
+            type = other.type;
+            positionNode = other.positionNode;
+            otherNode = other.otherNode;
+            offset[0] = other.offset[0];
+            offset[1] = other.offset[1];
+            radius = other.radius;
+            polygon = other.polygon;
+            circleSet = other.circleSet;
+            hitCircle = other.hitCircle;
+            lastPosition = other.lastPosition;
+            
+            other.positionNode = nullptr;
+            other.otherNode = nullptr;
+            other.polygon = nullptr;
+            
+            return *this;
         }
         
-        inline static HazardCollisionData createCircle(cocos2d::Node *positionNode, cocos2d::Vec2 offset, float radius, const HazardInfo &info)
+        inline static HazardCollisionData createCircle(cocos2d::Node *positionNode, cocos2d::Vec2 offset, float radius)
         {
             HazardCollisionData data;
             data.type = CollisionType::Circle;
@@ -68,14 +128,11 @@ namespace CollisionManager
             data.positionNode->retain();
             data.offset[0] = offset;
             data.radius = radius;
-            data.info = info;
-            
-            data.copyList = false;
             
-            return std::move(data);
+            return data;
         }
         
-        inline static HazardCollisionData createTwoOffsetCapsule(cocos2d::Node *positionNode, cocos2d::Vec2 offset1, cocos2d::Vec2 offset2, float radius, const HazardInfo &info)
+        inline static HazardCollisionData createTwoOffsetCapsule(cocos2d::Node *positionNode, cocos2d::Vec2 offset1, cocos2d::Vec2 offset2, float radius)
         {
             HazardCollisionData data;
             data.type = CollisionType::TwoOffsetCapsule;
@@ -84,14 +141,11 @@ namespace CollisionManager
             data.offset[0] = offset1;
             data.offset[1] = offset2;
             data.radius = radius;
-            data.info = info;
-            
-            data.copyList = false;
             
             return data;
         }
         
-        inline static HazardCollisionData createTwoNodeCapsule(cocos2d::Node *positionNode, cocos2d::Node *otherNode, cocos2d::Vec2 offset, float radius, const HazardInfo &info)
+        inline static HazardCollisionData createTwoNodeCapsule(cocos2d::Node *positionNode, cocos2d::Node *otherNode, cocos2d::Vec2 offset, float radius)
         {
             HazardCollisionData data;
             data.type = CollisionType::TwoNodeCapsule;
@@ -101,42 +155,51 @@ namespace CollisionManager
             data.otherNode->retain();
             data.offset[0] = offset;
             data.radius = radius;
-            data.info = info;
-            
-            data.copyList = false;
             
             return data;
         }
         
-        inline static HazardCollisionData createPolygon(cocos2d::Node *positionNode, cocos2d::Vec2 offset, const cocos2d::Vec2* polygonList, int polygonListSize, const HazardInfo &info, bool copyList = false)
+        inline static HazardCollisionData createPolygon(cocos2d::Node *positionNode, cocos2d::Vec2 offset, PolygonShape *polygon)
         {
             HazardCollisionData data;
             data.type = CollisionType::Polygon;
             data.positionNode = positionNode;
             data.positionNode->retain();
             data.offset[0] = offset;
-            data.info = info;
             
-            data.polygonListSize = polygonListSize;
-            if ((data.copyList = copyList))
-            {
-                cocos2d::Vec2 *newList = new cocos2d::Vec2[polygonListSize];
-                for (int i = 0; i < polygonListSize; i++) newList[i] = polygonList[i];
-                data.polygonList = newList;
-            }
-            else data.polygonList = polygonList;
+            data.polygon = polygon;
+            data.polygon->retain();
+            
+            return data;
+        }
+        
+        // The point list is interned as a PolygonShape, so hazards with the same points share one
+        inline static HazardCollisionData createPolygon(cocos2d::Node *positionNode, cocos2d::Vec2 offset, const cocos2d::Vec2* polygonList, int polygonListSize)
+        {
+            return createPolygon(positionNode, offset, PolygonShape::getOrCreate(polygonList, polygonListSize));
+        }
+        
+        inline static HazardCollisionData createCircleSet(cocos2d::Node *positionNode, CircleSet *circleSet)
+        {
+            HazardCollisionData data;
+            data.type = CollisionType::CircleSet;
+            data.positionNode = positionNode;
+            data.positionNode->retain();
+            data.circleSet = circleSet;
             
             return data;
         }
         
         ~HazardCollisionData()
         {
-            if (positionNode) positionNode->release();
-            if (otherNode) otherNode->release();
-            if (copyList) delete[] polygonList;
+            releaseResources();
         }
     };
     
+    typedef SlotMapHandle HazardHandle;
+    typedef SlotMapHandle PowerupHandle;
+    typedef SlotMapHandle ProjectileHandle;
+    
     struct PlayerCollisionData
     {
         cocos2d::Node *positionNode;
@@ -146,37 +209,37 @@ namespace CollisionManager
         cocos2d::Vec2 offset;
         float radius;
         
-        const cocos2d::Vec2* polygonList;
-        int polygonListSize;
+        PolygonShape *polygon;
         
-        std::function<void(const HazardCollisionData&)> delegate;
-        std::function<bool(const HazardCollisionData&)> projectileDelegate;
+        LastPosition lastPosition;
+        
+        // The delegates receive the handle of the hazard that was hit, which stays valid until they remove it
+        std::function<void(HazardHandle, const HazardCollisionData&, const HazardCollisionData::HazardInfo&)> delegate;
+        std::function<bool(HazardHandle, const HazardCollisionData&, const HazardCollisionData::HazardInfo&)> projectileDelegate;
         
         inline PlayerCollisionData(cocos2d::Node *positionNode, cocos2d::Vec2 offset, float radius, decltype(delegate) delegate, decltype(projectileDelegate) projectileDelegate)
         : positionNode(positionNode), offset(offset), radius(radius), delegate(delegate), projectileDelegate(projectileDelegate),
-          polygonList(nullptr), polygonListSize(0), type(CollisionType::Circle)
+          polygon(nullptr), type(CollisionType::Circle)
         {
             this->positionNode->retain();
         }
         
-        inline PlayerCollisionData(cocos2d::Node *positionNode, const cocos2d::Vec2* polygonList, int polygonListSize, float polygonListScale, decltype(delegate) delegate, decltype(projectileDelegate) projectileDelegate)
-        : positionNode(positionNode), polygonList(nullptr), polygonListSize(polygonListSize), delegate(delegate), projectileDelegate(projectileDelegate),
+        inline PlayerCollisionData(cocos2d::Node *positionNode, PolygonShape *polygon, decltype(delegate) delegate, decltype(projectileDelegate) projectileDelegate)
+        : positionNode(positionNode), polygon(polygon), delegate(delegate), projectileDelegate(projectileDelegate),
         offset(0, 0), radius(0), type(CollisionType::Polygon)
         {
             this->positionNode->retain();
-            
-            cocos2d::Vec2 *tempList = new cocos2d::Vec2[polygonListSize];
-            for (int i = 0; i < polygonListSize; i++) tempList[i] = polygonList[i] * polygonListScale;
-            this->polygonList = tempList;
+            this->polygon->retain();
         }
+
         
         inline PlayerCollisionData &operator=(PlayerCollisionData&& other)
         {
             if (positionNode) positionNode->release();
-            if (type == CollisionType::Polygon)
+            if (type == CollisionType::Polygon && polygon)
             {
-                delete[] polygonList;
-                polygonList = nullptr;
+                polygon->release();
+                polygon = nullptr;
             }
             
             positionNode = other.positionNode;
@@ -187,9 +250,8 @@ namespace CollisionManager
             other.positionNode = nullptr;
             if (other.type == CollisionType::Polygon)
             {
-                polygonList = other.polygonList;
-                other.polygonList = nullptr;
-                polygonListSize = other.polygonListSize;
+                polygon = other.polygon;
+                other.polygon = nullptr;
             }
             else
             {
@@ -205,7 +267,7 @@ namespace CollisionManager
         ~PlayerCollisionData()
         {
             if (positionNode) positionNode->release();
-            if (type == CollisionType::Polygon) delete[] polygonList;
+            if (type == CollisionType::Polygon && polygon) polygon->release();
         }
     };
     
@@ -215,40 +277,70 @@ namespace CollisionManager
         cocos2d::Vec2 offset;
         float radius;
         
-        std::function<void(const PlayerCollisionData&)> delegate;
-        inline PowerupCollisionData(cocos2d::Node *positionNode, cocos2d::Vec2 offset, float radius, decltype(delegate) delegate)
-        : positionNode(positionNode), offset(offset), radius(radius), delegate(delegate)
+        inline PowerupCollisionData(cocos2d::Node *positionNode, cocos2d::Vec2 offset, float radius)
+        : positionNode(positionNode), offset(offset), radius(radius)
         {
             if (positionNode) this->positionNode->retain();
         }
         
         inline PowerupCollisionData(PowerupCollisionData &&other)
-        : positionNode(other.positionNode), offset(other.offset), radius(other.radius), delegate(other.delegate)
+        : positionNode(other.positionNode), offset(other.offset), radius(other.radius)
         {
             other.positionNode = nullptr;
         }
         
+        inline PowerupCollisionData &operator=(PowerupCollisionData &&other)
+        {
+            if (this == &other) return *this;
+            if (positionNode) positionNode->release();
+            
+            positionNode = other.positionNode;
+            offset = other.offset;
+            radius = other.radius;
+            
+            other.positionNode = nullptr;
+            return *this;
+        }
+        
         ~PowerupCollisionData()
         {
             if (positionNode) positionNode->release();
         }
     };
     
+    typedef std::function<void(const PlayerCollisionData&)> PowerupDelegate;
+    
     struct ProjectileCollisionData
     {
         cocos2d::Node *positionNode;
         cocos2d::Vec2 offset;
         float radius;
         
+        LastPosition lastPosition;
+        
         inline ProjectileCollisionData(cocos2d::Node *positionNode, cocos2d::Vec2 offset, float radius) : positionNode(positionNode), offset(offset), radius(radius)
         {
             if (positionNode) this->positionNode->retain();
         }
         
         inline ProjectileCollisionData(ProjectileCollisionData &&other)
-        : positionNode(other.positionNode), offset(other.offset), radius(other.radius)
+        : positionNode(other.positionNode), offset(other.offset), radius(other.radius), lastPosition(other.lastPosition)
+        {
+            other.positionNode = nullptr;
+        }
+        
+        inline ProjectileCollisionData &operator=(ProjectileCollisionData &&other)
         {
+            if (this == &other) return *this;
+            if (positionNode) positionNode->release();
+            
+            positionNode = other.positionNode;
+            offset = other.offset;
+            radius = other.radius;
+            lastPosition = other.lastPosition;
+            
             other.positionNode = nullptr;
+            return *this;
         }
         
         ~ProjectileCollisionData()
@@ -258,12 +350,39 @@ namespace CollisionManager
     };
     
     void setPlayer(PlayerCollisionData &&collisionData);
-    void addHazard(HazardCollisionData &&collisionData);
-    void addPowerup(PowerupCollisionData &&collisionData);
-    void addProjectile(ProjectileCollisionData &&collisionData);
+    HazardHandle addHazard(HazardCollisionData &&collisionData, const HazardCollisionData::HazardInfo &info);
+    PowerupHandle addPowerup(PowerupCollisionData &&collisionData, PowerupDelegate delegate);
+    ProjectileHandle addProjectile(ProjectileCollisionData &&collisionData);
+    
+    // Removal is O(1); handles of entries that were already removed are ignored. When called
+    // from inside update() (e.g. from a delegate), the removal is applied at the end of the tick
+    void removeHazard(HazardHandle handle);
+    void removePowerup(PowerupHandle handle);
+    void removeProjectile(ProjectileHandle handle);
+    
+    // What the delegates do to a hazard that was hit: its nodes (and companions) are removed from their parents
+    // and the hazard is removed. For a circle set, only the circle that was hit is removed
+    void destroyHazard(HazardHandle handle);
+    
+    // Return nullptr if the handle is no longer valid
+    HazardCollisionData *getHazard(HazardHandle handle);
+    HazardCollisionData::HazardInfo *getHazardInfo(HazardHandle handle);
+    
+    int getHazardCount();
     
     void update();
     
+    // The playfield's height in world space, which sizes the broadphase cells and bounds how far a collider can
+    // move in a tick and still be swept. Whoever steps the collisions sets it (StandardPlayfieldHeight by default)
+    void setPlayfieldHeight(float height);
+    
+    // Lets update() split the sweep over the worker pool when there are enough hazards (on by default)
+    void setParallelSweep(bool enabled);
+    
+    // Cross-checks every batch kernel this build has and the CPU supports against the scalar tests, on random
+    // shapes; logs the mismatches of each and returns their total. Needs no scene or view
+    int verifyBatchKernels();
+    
     void clearCollisionData();
 }
 
@@ -26,6 +26,22 @@ ExecFunc *ExecFunc::create(float duration, decltype(execFunc) func)
     }
 }
 
+Oscillate *Oscillate::create(float period, float origin, float amplitude)
+{
+    Oscillate *pRet = new(std::nothrow) Oscillate();
+    if (pRet && pRet->init(period, origin, amplitude))
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+    else
+    {
+        delete pRet;
+        pRet = nullptr;
+        return nullptr;
+    }
+}
+
 UpdateNode *UpdateNode::create(decltype(execFunc) func)
 {
     UpdateNode *pRet = new(std::nothrow) UpdateNode();
@@ -67,6 +83,16 @@ bool ExecFunc::init(float duration, decltype(execFunc) func)
     return true;
 }
 
+bool Oscillate::init(float period, float origin, float amplitude)
+{
+    if (!ActionInterval::initWithDuration(period))
+        return false;
+    
+    this->origin = origin;
+    this->amplitude = amplitude;
+    return true;
+}
+
 bool UpdateNode::init(decltype(execFunc) func)
 {
     execFunc = func;
@@ -89,6 +115,18 @@ void ExecFunc::update(float interval)
     execFunc(getTarget(), interval);
 }
 
+void Oscillate::setOscillation(float period, float origin, float amplitude)
+{
+    setDuration(period);
+    this->origin = origin;
+    this->amplitude = amplitude;
+}
+
+void Oscillate::update(float interval)
+{
+    getTarget()->setPositionY(origin + amplitude * sin(2 * M_PI * interval));
+}
+
 void UpdateNode::step(float dt)
 {
     execFunc(getTarget(), dt);
@@ -22,6 +22,22 @@ public:
     virtual void update(float interval) override;
 };
 
+// Moves the target's y coordinate along a sine around origin, one period per duration; unlike an ExecFunc,
+// its parameters can be changed afterwards, so an instance can be reused (see HazardActionCache)
+class Oscillate : public cocos2d::ActionInterval
+{
+    float origin, amplitude;
+    
+    bool init(float period, float origin, float amplitude);
+    
+public:
+    static Oscillate *create(float period, float origin, float amplitude);
+    void setOscillation(float period, float origin, float amplitude);
+    inline float getOrigin() const { return origin; }
+    inline float getAmplitude() const { return amplitude; }
+    virtual void update(float interval) override;
+};
+
 class UpdateNode : public cocos2d::Action
 {
     std::function<void(cocos2d::Node*,float)> execFunc;
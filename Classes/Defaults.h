@@ -66,6 +66,7 @@ inline static void recursiveResume(cocos2d::Node *node)
 
 const cocos2d::Color3B BackgroundColor = 0x3993B0_c3;
 constexpr float StandardPlayfieldHeight = 400;
+constexpr float PlayerScale = 0.78125f;
 
 #if CC_TARGET_PLATFORM == CC_PLATFORM_WINRT
 
@@ -0,0 +1,99 @@
+//
+//  FixedTimestep.cpp
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#include "FixedTimestep.h"
+#include <algorithm>
+
+using namespace cocos2d;
+
+// Farther than this in a tick is a jump, not a movement
+constexpr float MaxInterpolatedDistance = 96;
+
+float FixedTimestep::getDefaultRate()
+{
+    int rate = UserDefault::getInstance()->getIntegerForKey("SimulationRate", 60);
+    return clampf(rate, 15, 240);
+}
+
+FixedTimestep::FixedTimestep(float rate) : accumulator(0)
+{
+    setRate(rate);
+}
+
+void FixedTimestep::setRate(float rate)
+{
+    step = 1/rate;
+    accumulator = std::min(accumulator, step);
+}
+
+int FixedTimestep::advance(float delta)
+{
+    accumulator = std::min(accumulator + delta, MaxTicksPerFrame * step);
+    
+    int ticks = int(accumulator/step);
+    accumulator -= ticks * step;
+    return ticks;
+}
+
+void TransformInterpolator::beginTick()
+{
+    // The entries are reused, so capturing doesn't allocate once it has seen the most nodes it'll see
+    std::swap(previous, current);
+    current.clear();
+}
+
+void TransformInterpolator::add(Node *node)
+{
+    current.push_back(Entry{ node, node->getPosition(), node->getRotation(), false });
+}
+
+void TransformInterpolator::endTick()
+{
+    // Sorted by node, so apply finds each node's previous entry by binary search
+    std::sort(current.begin(), current.end(), [] (const Entry &e1, const Entry &e2) { return e1.node.get() < e2.node.get(); });
+}
+
+void TransformInterpolator::apply(float alpha)
+{
+    for (auto &entry : current)
+    {
+        entry.applied = false;
+        
+        Node *node = entry.node.get();
+        if (!node->getParent() || node->getPosition() != entry.position || node->getRotation() != entry.rotation) continue;
+        
+        auto prev = std::lower_bound(previous.begin(), previous.end(), node, [] (const Entry &e, Node *node) { return e.node.get() < node; });
+        if (prev == previous.end() || prev->node.get() != node) continue;
+        if (prev->position.distanceSquared(entry.position) > MaxInterpolatedDistance*MaxInterpolatedDistance) continue;
+        
+        float turn = entry.rotation - prev->rotation;
+        while (turn > 180) turn -= 360;
+        while (turn < -180) turn += 360;
+        
+        node->setPosition(prev->position.lerp(entry.position, alpha));
+        node->setRotation(prev->rotation + alpha*turn);
+        entry.applied = true;
+    }
+}
+
+void TransformInterpolator::restore()
+{
+    for (auto &entry : current)
+        if (entry.applied)
+        {
+            entry.node->setPosition(entry.position);
+            entry.node->setRotation(entry.rotation);
+            entry.applied = false;
+        }
+}
+
+void TransformInterpolator::clear()
+{
+    previous.clear();
+    current.clear();
+}
@@ -0,0 +1,68 @@
+//
+//  FixedTimestep.h
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#ifndef FixedTimestep_h
+#define FixedTimestep_h
+
+#include "cocos2d.h"
+#include <vector>
+
+// Turns the frames' variable deltas into a whole number of fixed ticks, so the game steps the same way whatever
+// the display rate is: at 60 Hz, a 120 Hz display ticks every other frame, and a slow frame ticks twice
+class FixedTimestep
+{
+    float step, accumulator;
+
+public:
+    // Beyond this, the frame's time is dropped: a long frame slows the game down for a moment instead of
+    // making the next frames catch up
+    static constexpr int MaxTicksPerFrame = 4;
+    
+    // The rate the game ticks at: the "SimulationRate" setting, 60 if it isn't set
+    static float getDefaultRate();
+    
+    explicit FixedTimestep(float rate = getDefaultRate());
+    
+    void setRate(float rate);
+    inline float getStep() const { return step; }
+    
+    // How many ticks to run for the frame
+    int advance(float delta);
+    
+    // How far it is from the last tick to the next one, from 0 to 1
+    inline float getAlpha() const { return accumulator/step; }
+};
+
+// Draws nodes that move on fixed ticks between where they were on the last two ticks, so they move smoothly
+// even when a frame has no tick or two of them. The nodes are captured after each tick, and put where they
+// should be drawn just for the visit; nodes moved since the tick, new in it or that jumped are drawn as they are
+class TransformInterpolator
+{
+    struct Entry
+    {
+        cocos2d::RefPtr<cocos2d::Node> node;
+        cocos2d::Vec2 position;
+        float rotation;
+        bool applied;
+    };
+    
+    std::vector<Entry> previous, current;
+
+public:
+    void beginTick();
+    void add(cocos2d::Node *node);
+    void endTick();
+    
+    void apply(float alpha);
+    void restore();
+    
+    // For when the nodes are taken out or moved all at once (a reset, a restored game)
+    void clear();
+};
+
+#endif /* FixedTimestep_h */
@@ -0,0 +1,116 @@
+//
+//  FlameTrailNode.cpp
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#include "FlameTrailNode.h"
+
+using namespace cocos2d;
+
+// What each flame sprite used to run: a tint over TintTime, then shrinking to nothing over ShrinkTime
+constexpr float TintTime = 0.6, ShrinkTime = 0.4;
+static const Color3B TintAmount(8, 22, 129);
+constexpr float FlameRadius = 7.5;
+
+// Longer than the interval between the flames of a fireball
+constexpr float IdleTimeout = 0.1;
+
+FlameTrailNode *FlameTrailNode::create(const CollisionManager::HazardCollisionData::HazardInfo &info)
+{
+    FlameTrailNode *pRet = new(std::nothrow) FlameTrailNode();
+    if (pRet && pRet->init(info))
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+    else
+    {
+        delete pRet;
+        pRet = nullptr;
+        return nullptr;
+    }
+}
+
+bool FlameTrailNode::init(const CollisionManager::HazardCollisionData::HazardInfo &info)
+{
+    if (!Node::init())
+        return false;
+    
+    // Take the quad (texture coordinates and trimming included) from a sprite of the frame, centered on the origin
+    auto sprite = Sprite::createWithSpriteFrameName("HazardFireballFlame.png");
+    flameQuad = sprite->getQuad();
+    Vec3 center(sprite->getContentSize().width/2, sprite->getContentSize().height/2, 0);
+    for (auto vertex : { &flameQuad.tl, &flameQuad.bl, &flameQuad.tr, &flameQuad.br })
+        vertex->vertices -= center;
+    
+    texture = sprite->getTexture();
+    blendFunc = sprite->getBlendFunc();
+    flameReach = Vec2(sprite->getContentSize().width, sprite->getContentSize().height).length()/2;
+    idleTime = 0;
+    
+    setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP));
+    
+    handle = CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircleSet(this, this), info);
+    
+    return true;
+}
+
+void FlameTrailNode::emit(Vec2 position, Vec2 velocity, float fadeDelay)
+{
+    flames.push_back({ position - getPosition(), velocity, 0, fadeDelay, true });
+    idleTime = 0;
+}
+
+bool FlameTrailNode::step(float delta, const Rect &visiblePlayfield)
+{
+    Rect playfield(visiblePlayfield.origin - Vec2(flameReach, flameReach), visiblePlayfield.size + Size(2*flameReach, 2*flameReach));
+    auto offset = getPosition();
+    
+    circles.clear();
+    quads.clear();
+    
+    int count = 0;
+    for (auto flame : flames)
+    {
+        flame.age += delta;
+        auto position = flame.origin + flame.age * flame.velocity;
+        
+        float fade = 0, scale = 1;
+        if (flame.fadeDelay >= 0)
+        {
+            float time = flame.age - flame.fadeDelay;
+            fade = clampf(time/TintTime, 0, 1);
+            scale = 1 - clampf((time - TintTime)/ShrinkTime, 0, 1);
+            if (time >= TintTime + ShrinkTime) flame.alive = false;
+        }
+        
+        if (!flame.alive || !playfield.containsPoint(position + offset)) continue;
+        flames[count++] = flame;
+        
+        circles.push_back({ position, delta * flame.velocity, FlameRadius * scale });
+        
+        Color4B color(255 - TintAmount.r * fade, 255 - TintAmount.g * fade, 255 - TintAmount.b * fade, 255);
+        auto quad = flameQuad;
+        for (auto vertex : { &quad.tl, &quad.bl, &quad.tr, &quad.br })
+        {
+            vertex->vertices = vertex->vertices * scale + Vec3(position.x, position.y, 0);
+            vertex->colors = color;
+        }
+        quads.push_back(quad);
+    }
+    flames.resize(count);
+    
+    if (count == 0) idleTime += delta;
+    return count > 0 || idleTime < IdleTimeout;
+}
+
+void FlameTrailNode::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
+{
+    if (quads.empty()) return;
+    
+    quadCommand.init(_globalZOrder, texture->getName(), getGLProgramState(), blendFunc, quads.data(), quads.size(), transform, flags);
+    renderer->addCommand(&quadCommand);
+}
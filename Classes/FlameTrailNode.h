@@ -0,0 +1,61 @@
+//
+//  FlameTrailNode.h
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#ifndef FlameTrailNode_h
+#define FlameTrailNode_h
+
+#include "cocos2d.h"
+#include "CollisionManager.h"
+#include <vector>
+
+// The flames a fireball leaves behind (and the ones it explodes into), kept in a flat array instead of as a
+// sprite each: they're moved and faded from their age alone, drawn with one command and collided as one
+// circle set. Created and stepped by the HazardSelector (see HazardSelector::createFlameTrail)
+class FlameTrailNode : public cocos2d::Node, public CollisionManager::CircleSet
+{
+    struct Flame
+    {
+        cocos2d::Vec2 origin, velocity;
+        float age, fadeDelay;       // fadeDelay is negative for the flames that only go away offscreen
+        bool alive;
+    };
+    
+    std::vector<Flame> flames;
+    std::vector<Circle> circles;
+    std::vector<cocos2d::V3F_C4B_T2F_Quad> quads;
+    
+    cocos2d::V3F_C4B_T2F_Quad flameQuad;
+    cocos2d::RefPtr<cocos2d::Texture2D> texture;
+    cocos2d::BlendFunc blendFunc;
+    cocos2d::QuadCommand quadCommand;
+    float flameReach;
+    float idleTime;
+    
+    CollisionManager::HazardHandle handle;
+    
+    bool init(const CollisionManager::HazardCollisionData::HazardInfo &info);
+
+public:
+    static FlameTrailNode *create(const CollisionManager::HazardCollisionData::HazardInfo &info);
+    
+    // The position is in the parent's space; a fading flame starts fading after fadeDelay
+    void emit(cocos2d::Vec2 position, cocos2d::Vec2 velocity, float fadeDelay = -1);
+    
+    // Ages every flame by delta, dropping the ones that faded out or left the playfield (in the parent's space).
+    // Returns false once the trail is empty and nothing was emitted for a while, which means its fireball is gone
+    bool step(float delta, const cocos2d::Rect &playfield);
+    
+    inline CollisionManager::HazardHandle getHazardHandle() const { return handle; }
+    
+    virtual const std::vector<Circle> &getCollisionCircles() const override { return circles; }
+    virtual void removeCollisionCircle(int index) override { flames[index].alive = false; }
+    
+    virtual void draw(cocos2d::Renderer *renderer, const cocos2d::Mat4 &transform, uint32_t flags) override;
+};
+
+#endif /* FlameTrailNode_h */
@@ -0,0 +1,68 @@
+//
+//  FlipbookSprite.cpp
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#include "FlipbookSprite.h"
+#include "Defaults.h"
+
+using namespace cocos2d;
+
+FlipbookClip::FlipbookClip(const std::string &prefix, int count) : frames(count), uniform(true)
+{
+    for (int i = 0; i < count; i++)
+    {
+        auto frame = SpriteFrameCache::getInstance()->getSpriteFrameByName(prefix + ulongToString(i+1) + ".png");
+        CCASSERT(frame, "FlipbookClip: frame not found");
+        frames.pushBack(frame);
+    }
+    
+    auto first = frames.front();
+    for (auto frame : frames)
+    {
+        if (frame->getTexture() != first->getTexture() || frame->isRotated() != first->isRotated() ||
+            !frame->getRect().size.equals(first->getRect().size) || !frame->getOriginalSize().equals(first->getOriginalSize()) ||
+            frame->getOffset() != first->getOffset() || frame->hasPolygonInfo() || frame->hasAnchorPoint())
+        {
+            uniform = false;
+            break;
+        }
+    }
+}
+
+bool FlipbookSprite::initWithClip(const FlipbookClip &clip, int index)
+{
+    if (!Sprite::initWithSpriteFrame(clip.at(index)))
+        return false;
+    
+    this->clip = &clip;
+    frameIndex = index;
+    return true;
+}
+
+void FlipbookSprite::setFrameIndex(int index)
+{
+    if (index == frameIndex) return;
+    frameIndex = index;
+    
+    auto frame = clip->at(index);
+    if (!clip->isUniform())
+    {
+        setSpriteFrame(frame);
+        return;
+    }
+    
+    // Everything but the atlas rect is the same as the frame shown, so the size, offset and vertices stay;
+    // the polygon info points at the quad itself, so it sees the new coordinates as they are
+    CC_SAFE_RELEASE(_spriteFrame);
+    _spriteFrame = frame;
+    _spriteFrame->retain();
+    
+    _rect = frame->getRect();
+    setTextureCoords(_rect);
+    
+    if (_batchNode) setDirty(true);
+}
@@ -0,0 +1,61 @@
+//
+//  FlipbookSprite.h
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#ifndef FlipbookSprite_h
+#define FlipbookSprite_h
+
+#include "cocos2d.h"
+#include <string>
+
+// A numbered run of sprite frames (prefix + "1.png" onwards), looked up in the SpriteFrameCache once, so
+// playing it is indexing instead of building and hashing names. It's uniform when the frames differ only in
+// where they are on the atlas: same texture, size, trim offset and rotation, and no polygon of their own
+class FlipbookClip
+{
+    cocos2d::Vector<cocos2d::SpriteFrame*> frames;
+    bool uniform;
+
+public:
+    FlipbookClip(const std::string &prefix, int count);
+    
+    inline int size() const { return (int)frames.size(); }
+    inline cocos2d::SpriteFrame *at(int index) const { return frames.at(index); }
+    inline bool isUniform() const { return uniform; }
+};
+
+// A sprite showing one frame of a clip at a time. On a uniform clip, changing frames only moves the texture
+// coordinates of the quad it already has; otherwise it goes through setSpriteFrame. The clip must outlive it
+class FlipbookSprite : public cocos2d::Sprite
+{
+    const FlipbookClip *clip;
+    int frameIndex;
+    
+    bool initWithClip(const FlipbookClip &clip, int index);
+
+public:
+    void setFrameIndex(int index);
+    inline int getFrameIndex() const { return frameIndex; }
+    
+    static FlipbookSprite* create(const FlipbookClip &clip, int index = 0)
+    {
+        FlipbookSprite *pRet = new(std::nothrow) FlipbookSprite();
+        if (pRet && pRet->initWithClip(clip, index))
+        {
+            pRet->autorelease();
+            return pRet;
+        }
+        else
+        {
+            delete pRet;
+            pRet = NULL;
+            return NULL;
+        }
+    }
+};
+
+#endif /* FlipbookSprite_h */
@@ -0,0 +1,60 @@
+//
+//  GameEvents.cpp
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#include "GameEvents.h"
+#include "cocos2d.h"
+
+using namespace cocos2d;
+
+namespace GameEvents
+{
+    static ListenerId lastListenerId = 0;
+    
+    // Only the channels with something pending are delivered; the table is filled as they're posted to
+    static void (*pendingDeliveries[(int)Channel::Count])() = {};
+    static void (*pendingDiscards[(int)Channel::Count])() = {};
+    static unsigned int pendingMask = 0;
+    static bool flushInstalled = false;
+}
+
+GameEvents::ListenerId GameEvents::nextListenerId()
+{
+    return ++lastListenerId;
+}
+
+void GameEvents::markPending(Channel channel, void (*deliver)(), void (*discard)())
+{
+    pendingDeliveries[(int)channel] = deliver;
+    pendingDiscards[(int)channel] = discard;
+    pendingMask |= 1u << (int)channel;
+    
+    if (!flushInstalled)
+    {
+        Director::getInstance()->getEventDispatcher()->addCustomEventListener(Director::EVENT_AFTER_UPDATE, [] (EventCustom*) { flush(); });
+        flushInstalled = true;
+    }
+}
+
+void GameEvents::flush()
+{
+    // Listeners may post again while being delivered; those are left to the next flush
+    auto mask = pendingMask;
+    pendingMask = 0;
+    
+    for (int i = 0; mask != 0; i++, mask >>= 1)
+        if (mask & 1) pendingDeliveries[i]();
+}
+
+void GameEvents::discardPending()
+{
+    auto mask = pendingMask;
+    pendingMask = 0;
+    
+    for (int i = 0; mask != 0; i++, mask >>= 1)
+        if (mask & 1) pendingDiscards[i]();
+}
@@ -0,0 +1,210 @@
+//
+//  GameEvents.h
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#ifndef GameEvents_h
+#define GameEvents_h
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+// The events gameplay nodes send each other while a game runs. Each payload struct is its own channel, so
+// posting one is a plain call into the channel's listener list: there's no EventCustom, no string lookup and
+// no void* payload. Events that fire many times a frame are batched: the ones posted in a frame are merged
+// and delivered once, after the frame's update or before the next unbatched event, whichever comes first (see flush)
+namespace GameEvents
+{
+    enum class Channel : int
+    {
+        ScoreUpdate, LifeUpdate, DoubleScore, AdvancePowerup, TutorialMessage, Count
+    };
+    
+    // Points before the multiplier; batched, so the score label restarts its count-up once per frame
+    struct ScoreUpdate
+    {
+        static constexpr Channel channel = Channel::ScoreUpdate;
+        static constexpr bool batched = true;
+        
+        int points;
+        
+        inline void merge(const ScoreUpdate &other) { points += other.points; }
+    };
+    
+    // The player's health after being hit (0 when it dies), or minus it when it only changed otherwise
+    struct LifeUpdate
+    {
+        static constexpr Channel channel = Channel::LifeUpdate;
+        static constexpr bool batched = false;
+        
+        int health;
+    };
+    
+    struct DoubleScore
+    {
+        static constexpr Channel channel = Channel::DoubleScore;
+        static constexpr bool batched = false;
+        
+        bool enabled;
+    };
+    
+    struct AdvancePowerup
+    {
+        static constexpr Channel channel = Channel::AdvancePowerup;
+        static constexpr bool batched = false;
+    };
+    
+    // Shown by the TutorialNode; see TutorialNode::processMessage for the markup
+    struct TutorialMessage
+    {
+        static constexpr Channel channel = Channel::TutorialMessage;
+        static constexpr bool batched = false;
+        
+        std::string text;
+    };
+    
+    // Identifies a listener inside its channel; 0 is never a listener
+    typedef unsigned int ListenerId;
+    
+    ListenerId nextListenerId();
+    
+    // Called when the first event of a batched channel is posted in a frame, so flush knows to deliver it
+    void markPending(Channel channel, void (*deliver)(), void (*discard)());
+    
+    // Delivers the batched events posted since the last flush. The Director's after-update event calls it
+    // every frame once something was posted, and so does every unbatched post; it only needs to be called by
+    // hand outside the Director's loop, or before a listener's state changes (see ScoreNode::update)
+    void flush();
+    
+    // Drops the batched events not delivered yet, like the score posted by the last hazards of a game being restarted
+    void discardPending();
+    
+    template <typename Event>
+    class ChannelState
+    {
+        struct Listener
+        {
+            ListenerId id;
+            std::function<void(const Event&)> callback;
+        };
+        
+        // Listeners added while dispatching wait in added, and removed ones are only nulled, so the list
+        // never changes under a dispatch
+        std::vector<Listener> listeners, added;
+        int dispatchDepth = 0;
+        bool hasRemoved = false;
+        
+        Event pending;
+        bool hasPending = false;
+        
+        void settle()
+        {
+            if (hasRemoved)
+            {
+                listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [] (const Listener &l) { return !l.callback; }), listeners.end());
+                hasRemoved = false;
+            }
+            
+            for (auto &listener : added) listeners.push_back(std::move(listener));
+            added.clear();
+        }
+        
+        // The batched events posted before it are delivered first, so the order between channels is kept: the
+        // points earned before a hit are scored before the hit resets the multiplier, and none are lost to a death
+        void post(const Event &event, std::false_type)
+        {
+            flush();
+            dispatch(event);
+        }
+        void post(const Event &event, std::true_type)
+        {
+            if (hasPending) pending.merge(event);
+            else
+            {
+                pending = event;
+                hasPending = true;
+                markPending(Event::channel, &ChannelState::deliverPending, &ChannelState::discardPending);
+            }
+        }
+        
+        static void deliverPending()
+        {
+            auto &state = get();
+            if (!state.hasPending) return;
+            
+            state.hasPending = false;
+            Event event = state.pending;
+            state.dispatch(event);
+        }
+        
+        static void discardPending() { get().hasPending = false; }
+    
+    public:
+        static ChannelState &get()
+        {
+            static ChannelState state;
+            return state;
+        }
+        
+        ListenerId subscribe(std::function<void(const Event&)> callback)
+        {
+            Listener listener = { nextListenerId(), std::move(callback) };
+            auto id = listener.id;
+            (dispatchDepth > 0 ? added : listeners).push_back(std::move(listener));
+            return id;
+        }
+        
+        void unsubscribe(ListenerId id)
+        {
+            for (auto &list : { &listeners, &added })
+                for (auto it = list->begin(); it != list->end(); ++it)
+                    if (it->id == id)
+                    {
+                        if (dispatchDepth > 0 && list == &listeners)
+                        {
+                            it->callback = nullptr;
+                            hasRemoved = true;
+                        }
+                        else list->erase(it);
+                        return;
+                    }
+        }
+        
+        void dispatch(const Event &event)
+        {
+            dispatchDepth++;
+            for (size_t i = 0; i < listeners.size(); i++)
+                if (listeners[i].callback) listeners[i].callback(event);
+            if (--dispatchDepth == 0) settle();
+        }
+        
+        inline void post(const Event &event) { post(event, std::integral_constant<bool, Event::batched>()); }
+    };
+    
+    template <typename Event>
+    inline ListenerId subscribe(std::function<void(const Event&)> callback)
+    {
+        return ChannelState<Event>::get().subscribe(std::move(callback));
+    }
+    
+    // Safe to call from inside a listener, even the one being removed
+    template <typename Event>
+    inline void unsubscribe(ListenerId id)
+    {
+        ChannelState<Event>::get().unsubscribe(id);
+    }
+    
+    template <typename Event>
+    inline void post(const Event &event)
+    {
+        ChannelState<Event>::get().post(event);
+    }
+}
+
+#endif /* GameEvents_h */
@@ -23,6 +23,7 @@
 #include "BlurFilter.h"
 #include "FacebookManager.h"
 #include "SoundManager.h"
+#include "WorldSnapshot.h"
 
 using namespace cocos2d;
 
@@ -45,22 +46,26 @@ bool GameScene::init()
     playfieldSize = Size(size.width/size.height * StandardPlayfieldHeight, StandardPlayfieldHeight);
     gameLayer->setScale(size.height/StandardPlayfieldHeight);
     
-    uiLayer->addChild(ScoreNode::create(size));
-    uiLayer->addChild(LifeMarkers::create(size));
-    uiLayer->addChild(TutorialNode::create(size));
+    uiLayer->addChild(scoreNode = ScoreNode::create(size));
+    uiLayer->addChild(lifeMarkers = LifeMarkers::create(size));
+    uiLayer->addChild(tutorialNode = TutorialNode::create(size));
     
     backgroundLayer->addChild(BackgroundNode::create());
     
     CollisionManager::clearCollisionData();
+    CollisionManager::setPlayfieldHeight(size.height);
     
     scheduleUpdate();
-    schedule([] (float delta) { CollisionManager::update(); }, "CollisionUpdate");
     
-    gameLayer->addChild(PlayerNode::create());
+    // Below everything else on the game layer, even when it's added back on reset
+    playerNode = PlayerNode::create();
+    gameLayer->addChild(playerNode, -1);
+    powerupSpawner = nullptr;
     bgTime = 0;
-    alreadyChecked = alreadyChecked2 = false;
+    alreadyChecked = alreadyChecked2 = restorePending = false;
+    simulationPaused = true;
     
-    lifeUpdateListener = _eventDispatcher->addCustomEventListener("LifeUpdate", CC_CALLBACK_1(GameScene::lifeUpdate, this));
+    lifeUpdateListener = GameEvents::subscribe<GameEvents::LifeUpdate>(CC_CALLBACK_1(GameScene::lifeUpdate, this));
     
     backgroundListener = _eventDispatcher->addCustomEventListener("DidEnterBackground", CC_CALLBACK_1(GameScene::toBackground, this));
     foregroundListener = _eventDispatcher->addCustomEventListener("WillEnterForeground", CC_CALLBACK_1(GameScene::toForeground, this));
@@ -96,8 +101,10 @@ bool GameScene::init()
 
 GameScene::~GameScene()
 {
-    unschedule("CollisionUpdate");
-    _eventDispatcher->removeEventListener(lifeUpdateListener);
+    // Left to the menu; a game that's over was already discarded
+    WorldSnapshot::discard();
+    
+    GameEvents::unsubscribe<GameEvents::LifeUpdate>(lifeUpdateListener);
     _eventDispatcher->removeEventListener(backgroundListener);
     _eventDispatcher->removeEventListener(foregroundListener);
     
@@ -123,6 +130,7 @@ void GameScene::onEnter()
     }
     
     recursivePause(this);
+    simulationPaused = true;
 }
 
 void GameScene::onExitTransitionDidStart()
@@ -130,6 +138,7 @@ void GameScene::onExitTransitionDidStart()
     LayerColor::onExitTransitionDidStart();
     Device::setKeepScreenOn(false);
     recursivePause(this);
+    simulationPaused = true;
 }
 
 void GameScene::onEnterTransitionDidFinish()
@@ -137,18 +146,30 @@ void GameScene::onEnterTransitionDidFinish()
     LayerColor::onEnterTransitionDidFinish();
     Device::setKeepScreenOn(true);
     recursiveResume(this);
+    simulationPaused = false;
     
     if (!alreadyChecked)
     {
         checkTutorialPhase();
         alreadyChecked = true;
     }
+    
+    if (restorePending)
+    {
+        restorePending = false;
+        if (restoreSnapshot()) gotoPauseScreen();
+        else WorldSnapshot::discard();
+    }
 }
 
 void GameScene::toBackground(EventCustom *event)
 {
     if (Director::getInstance()->getRunningScene() == getScene())
+    {
         recursivePause(this);
+        simulationPaused = true;
+        saveSnapshot();
+    }
 }
 
 void GameScene::toForeground(EventCustom *event)
@@ -161,6 +182,7 @@ void GameScene::toForeground(EventCustom *event)
         if (Director::getInstance()->getRunningScene() == getScene())
         {
             recursiveResume(this);
+            simulationPaused = false;
             
             if (gameLayer->getChildByName("PlayerNode") != nullptr)
                 gotoPauseScreen();
@@ -173,9 +195,9 @@ void GameScene::toForeground(EventCustom *event)
 #endif
 }
 
-void GameScene::lifeUpdate(EventCustom *event)
+void GameScene::lifeUpdate(const GameEvents::LifeUpdate &event)
 {
-    auto number = *static_cast<int*>(event->getUserData());
+    auto number = event.health;
     
     if (number >= 0)
     {
@@ -187,6 +209,7 @@ void GameScene::lifeUpdate(EventCustom *event)
         if (number == 0)
         {
             // Proceed to finalize the game
+            WorldSnapshot::discard();
             gameLayer->removeChildByName("PlayerNode");
             uiLayer->addChild(ResultNode::create(getContentSize()));
             uiLayer->getChildByName<ui::Button*>("PauseButton")->setEnabled(false);
@@ -203,22 +226,16 @@ void GameScene::checkTutorialPhase()
 {
     if (!UserDefault::getInstance()->getBoolForKey("TutorialFirstPhase"))
     {
-        std::string str = "$Touch the screen to start the ship";
-        _eventDispatcher->dispatchCustomEvent("TutorialMessage", &str);
-        
-        str = "Tilt your device to move the ship";
-        _eventDispatcher->dispatchCustomEvent("TutorialMessage", &str);
-        
-        str = "#{TutorialDone}$Tap and hold to freeze";
-        _eventDispatcher->dispatchCustomEvent("TutorialMessage", &str);
-
-		str = "You can only move on\nthe left half of the screen";
-		_eventDispatcher->dispatchCustomEvent("TutorialMessage", &str);
+        GameEvents::post(GameEvents::TutorialMessage{"$Touch the screen to start the ship"});
+        GameEvents::post(GameEvents::TutorialMessage{"Tilt your device to move the ship"});
+        GameEvents::post(GameEvents::TutorialMessage{"#{TutorialDone}$Tap and hold to freeze"});
+		GameEvents::post(GameEvents::TutorialMessage{"You can only move on\nthe left half of the screen"});
         
         tutorialDoneListener = _eventDispatcher->addCustomEventListener("TutorialDone", [this] (EventCustom *event)
         {
-            gameLayer->addChild(HazardSelector::create());
-            gameLayer->addChild(PowerupSpawner::create());
+            hazardSelector = HazardSelector::create();
+            gameLayer->addChild(hazardSelector);
+            gameLayer->addChild(powerupSpawner = PowerupSpawner::create());
             
             auto pauseButton = createPauseButton();
             pauseButton->setCascadeOpacityEnabled(true);
@@ -231,8 +248,9 @@ void GameScene::checkTutorialPhase()
     }
     else
     {
-        gameLayer->addChild(HazardSelector::create());
-        gameLayer->addChild(PowerupSpawner::create());
+        hazardSelector = HazardSelector::create();
+        gameLayer->addChild(hazardSelector);
+        gameLayer->addChild(powerupSpawner = PowerupSpawner::create());
 
 		if (global_ShipSelect != 0)
 		{
@@ -247,8 +265,7 @@ void GameScene::checkTutorialPhase()
 					"This ship is smaller, but it has a weaker armor"
 				};
 
-				std::string msg = messages[global_ShipSelect - 1];
-				_eventDispatcher->dispatchCustomEvent("TutorialMessage", &msg);
+				GameEvents::post(GameEvents::TutorialMessage{messages[global_ShipSelect - 1]});
 
 				UserDefault::getInstance()->setBoolForKey(str, true);
 			}
@@ -279,6 +296,8 @@ void GameScene::gotoPauseScreen()
     auto color = Color4F(colorb);
     
     for (Node *node : getChildren()) recursivePause(node);
+    simulationPaused = true;
+    saveSnapshot();
 
     firstRenderTexture->beginWithClear(color.r, color.g, color.b, color.a);
     visit(_director->getRenderer(), _director->getMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW), true);
@@ -322,29 +341,77 @@ void GameScene::pauseButtonPressed(Ref *object, ui::Widget::TouchEventType type)
         gotoPauseScreen();
 }
 
+void GameScene::saveSnapshot()
+{
+    if (!hazardSelector || !powerupSpawner || !playerNode->getParent()) return;
+    
+    WorldSnapshot::Writer writer;
+    WorldSnapshot::writeHeader(writer, global_ShipSelect, playfieldSize);
+    writer.write(bgTime);
+    writer.write(uint8_t(colorID));
+    
+    playerNode->saveSnapshot(writer);
+    scoreNode->saveSnapshot(writer);
+    hazardSelector->saveSnapshot(writer);
+    powerupSpawner->saveSnapshot(writer);
+    
+    WorldSnapshot::save(writer);
+}
+
+bool GameScene::restoreSnapshot()
+{
+    auto data = WorldSnapshot::load();
+    if (data.isNull() || !hazardSelector || !powerupSpawner) return false;
+    
+    WorldSnapshot::Reader reader(data.getBytes(), data.getSize());
+    unsigned long ship;
+    Size snapshotPlayfield;
+    if (!WorldSnapshot::readHeader(reader, ship, snapshotPlayfield) || ship != global_ShipSelect || !snapshotPlayfield.equals(playfieldSize))
+        return false;
+    
+    // Read over a new game, which is rewound again if anything in it doesn't check out
+    reset();
+    bgTime = reader.read<float>();
+    colorID = reader.read<uint8_t>() % colorsSize;
+    
+    bool restored = playerNode->restoreSnapshot(reader) && scoreNode->restoreSnapshot(reader) &&
+                    hazardSelector->restoreSnapshot(reader) && powerupSpawner->restoreSnapshot(reader) && reader.isAtEnd();
+    if (!restored) reset();
+    
+    return restored;
+}
+
 void GameScene::reset()
 {
     bgTime = 0;
     colorID = 0;
+    WorldSnapshot::discard();
     
-    gameLayer->removeAllChildren();
+    // Everything is rewound in place, so the nodes keep their pools, listeners and textures. The score the
+    // last hazards posted this frame belongs to the game that is over
+    GameEvents::discardPending();
+    CollisionManager::clearCollisionData();
     
-    gameLayer->addChild(PlayerNode::create());
-    gameLayer->addChild(HazardSelector::create());
-    gameLayer->addChild(PowerupSpawner::create());
+    // What's left besides those are the player's projectiles and the Advance powerup's dimming
+    for (ssize_t i = gameLayer->getChildrenCount()-1; i >= 0; i--)
+    {
+        auto child = gameLayer->getChildren().at(i);
+        if (child != playerNode && child != hazardSelector && child != powerupSpawner) child->removeFromParent();
+    }
     
-    uiLayer->removeAllChildren();
+    if (hazardSelector) hazardSelector->reset();
+    if (powerupSpawner) powerupSpawner->reset();
     
-    auto size = getContentSize();
-    uiLayer->addChild(ScoreNode::create(size));
-    uiLayer->addChild(LifeMarkers::create(size));
-    uiLayer->addChild(TutorialNode::create(size));
-    createPauseButton();
+    playerNode->reset();
+    playerInterpolator.clear();
+    if (!playerNode->getParent()) gameLayer->addChild(playerNode, -1);
     
-    backgroundLayer->removeAllChildren();
-    backgroundLayer->addChild(BackgroundNode::create());
+    scoreNode->restart();
+    lifeMarkers->reset();
+    tutorialNode->clearMessages();
     
-    CollisionManager::clearCollisionData();
+    auto pauseButton = uiLayer->getChildByName<ui::Button*>("PauseButton");
+    if (pauseButton) pauseButton->setEnabled(true);
 }
 
 void GameScene::update(float delta)
@@ -362,9 +429,39 @@ void GameScene::update(float delta)
     
     float index = bgTime/FadeTime;
     setColor(Color3B(color1.r + index * (color2.r-color1.r), color1.g + index * (color2.g-color1.g), color1.b + index * (color2.b - color1.b)));
+    
+    if (!simulationPaused)
+        for (int ticks = timestep.advance(delta); ticks > 0; ticks--) tick(timestep.getStep());
+}
+
+void GameScene::tick(float step)
+{
+    // The hazards see where the player was at the end of the last tick, then the collisions are
+    // tested once everything has moved
+    if (hazardSelector)
+    {
+        hazardSelector->worldState.refresh(playerNode, playfieldSize, hazardSelector->speed, step);
+        hazardSelector->tick(step);
+    }
+    
+    if (playerNode->getParent())
+    {
+        playerNode->update(step);
+        
+        playerInterpolator.beginTick();
+        playerInterpolator.add(playerNode);
+        playerInterpolator.endTick();
+    }
+    
+    CollisionManager::update();
 }
 
 void GameScene::visit(Renderer *renderer, const Mat4& parentTransform, uint32_t parentFlags)
 {
+    float alpha = timestep.getAlpha();
+    if (hazardSelector) hazardSelector->setInterpolation(alpha);
+    
+    playerInterpolator.apply(alpha);
     LayerColor::visit(renderer, parentTransform, parentFlags);
+    playerInterpolator.restore();
 }
\ No newline at end of file
@@ -11,6 +11,15 @@
 
 #include "cocos2d.h"
 #include "ui/CocosGUI.h"
+#include "HazardSelector.h"
+#include "PlayerNode.h"
+#include "GameEvents.h"
+#include "FixedTimestep.h"
+
+class PowerupSpawner;
+class ScoreNode;
+class LifeMarkers;
+class TutorialNode;
 
 class GameScene : public cocos2d::LayerColor
 {
@@ -19,7 +28,18 @@ class GameScene : public cocos2d::LayerColor
     int colorID;
     float bgTime;
     cocos2d::Node *gameLayer, *uiLayer, *backgroundLayer;
-    cocos2d::EventListenerCustom *lifeUpdateListener, *tutorialDoneListener;
+    
+    // Kept to fill the hazards' world state every frame; they may have been removed from the game layer already
+    cocos2d::RefPtr<PlayerNode> playerNode;
+    cocos2d::RefPtr<HazardSelector> hazardSelector;
+    
+    // Kept for reset, which rewinds them instead of creating them again; they stay on their layers
+    PowerupSpawner *powerupSpawner;
+    ScoreNode *scoreNode;
+    LifeMarkers *lifeMarkers;
+    TutorialNode *tutorialNode;
+    cocos2d::EventListenerCustom *tutorialDoneListener;
+    GameEvents::ListenerId lifeUpdateListener;
     cocos2d::EventListenerCustom *backgroundListener, *foregroundListener;
     
 #if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
@@ -33,9 +53,19 @@ class GameScene : public cocos2d::LayerColor
     
     cocos2d::Size playfieldSize;
     
-    bool alreadyChecked, alreadyChecked2;
+    // The player, the hazards and the collisions are stepped on fixed ticks; the rest of the scene, the UI
+    // and the powerups follow the frames
+    FixedTimestep timestep;
+    TransformInterpolator playerInterpolator;
+    
+    // The ticks are run by the scene's own update, which keeps running while the children are paused; so
+    // this stops them whenever the game is paused (the pause screen, the background, the transitions)
+    bool simulationPaused;
     
-    void lifeUpdate(cocos2d::EventCustom *event);
+    bool alreadyChecked, alreadyChecked2, restorePending;
+    
+    void tick(float step);
+    void lifeUpdate(const GameEvents::LifeUpdate &event);
     void checkTutorialPhase();
     cocos2d::ui::Button *createPauseButton();
     
@@ -46,6 +76,10 @@ class GameScene : public cocos2d::LayerColor
     
     void gotoPauseScreen();
     
+    // Only while a game is going on: not during the tutorial's first phase, nor after the player died
+    void saveSnapshot();
+    bool restoreSnapshot();
+    
 public:
     virtual void onEnter() override;
     virtual void onExitTransitionDidStart() override;
@@ -58,6 +92,10 @@ public:
     
     void reset();
     
+    // The game is taken from the saved snapshot once the scene is on, and it starts on the pause screen;
+    // the snapshot's ship must be selected before the scene is created
+    inline void resumeFromSnapshot() { restorePending = true; }
+    
     CREATE_FUNC(GameScene);
     
     virtual ~GameScene();
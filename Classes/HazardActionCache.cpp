@@ -0,0 +1,62 @@
+//
+//  HazardActionCache.cpp
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#include "HazardActionCache.h"
+
+using namespace cocos2d;
+
+void HazardActionCache::define(HazardActionTemplate type, BuildFunction build, BindFunction bind, int prewarm)
+{
+    auto &tmpl = templates[(int)type];
+    tmpl.tag = getTag(type);
+    tmpl.build = build;
+    tmpl.bind = bind;
+    tmpl.arena.clear();
+    tmpl.cursor = 0;
+    
+    grow(tmpl, prewarm);
+}
+
+void HazardActionCache::grow(Template &tmpl, size_t count)
+{
+    // The built actions are autoreleased; draining them right here leaves the arena as their only owner,
+    // which is what tells a free instance apart, even before the frame's pool is drained
+    AutoreleasePool scratch;
+    
+    tmpl.arena.reserve(tmpl.arena.size() + count);
+    while (count--)
+    {
+        tmpl.arena.push_back(tmpl.build());
+        tmpl.arena.back()->setTag(tmpl.tag);
+    }
+}
+
+Action *HazardActionCache::instantiate(HazardActionTemplate type, const HazardActionParams &params)
+{
+    auto &tmpl = templates[(int)type];
+    CCASSERT(tmpl.build, "The template must be defined before being instantiated!");
+    
+    // Round robin from after the last one handed out, so it's usually found at the first try
+    size_t size = tmpl.arena.size(), index = size;
+    for (size_t i = 0; i < size; i++)
+    {
+        size_t candidate = (tmpl.cursor + i) % size;
+        if (tmpl.arena[candidate]->getReferenceCount() == 1)
+        {
+            index = candidate;
+            break;
+        }
+    }
+    
+    if (index == size) grow(tmpl, std::max(size, size_t(1)));
+    tmpl.cursor = index+1;
+    
+    auto action = tmpl.arena[index].get();
+    if (tmpl.bind) tmpl.bind(action, params);
+    return action;
+}
@@ -0,0 +1,66 @@
+//
+//  HazardActionCache.h
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#ifndef HazardActionCache_h
+#define HazardActionCache_h
+
+#include "cocos2d.h"
+#include "CollisionManager.h"
+#include <vector>
+
+// The action graphs hazards run on every spawn, defined once (see defineHazardActionTemplates)
+enum class HazardActionTemplate : int
+{
+    CubeSpin, CubeOscillate, Retire, JetFlame, Shooter, Count
+};
+
+// What changes from one instance to the other; each template reads only the fields it needs
+struct HazardActionParams
+{
+    float period = 1, origin = 0, amplitude = 0;
+    int score = 0, count = 0;
+    cocos2d::Vec2 direction, velocity;
+    CollisionManager::HazardHandle handle;
+};
+
+// Keeps an arena of already built instances of each template and hands out one that isn't in use, with
+// the instance's parameters bound into it, so spawning doesn't allocate any actions once the arena is
+// warm. An instance is in use while anything besides the arena holds it (an action manager, the mover)
+class HazardActionCache
+{
+public:
+    typedef cocos2d::Action *(*BuildFunction)();
+    typedef void (*BindFunction)(cocos2d::Action *action, const HazardActionParams &params);
+
+private:
+    struct Template
+    {
+        int tag = cocos2d::Action::INVALID_TAG;
+        BuildFunction build = nullptr;
+        BindFunction bind = nullptr;
+        std::vector<cocos2d::RefPtr<cocos2d::Action>> arena;
+        size_t cursor = 0;
+    };
+    
+    Template templates[(int)HazardActionTemplate::Count];
+    
+    void grow(Template &tmpl, size_t count);
+
+public:
+    // Instances are tagged with their template, so the one a hazard is running can be found again with getActionByTag
+    inline static int getTag(HazardActionTemplate type) { return 0x7200 + (int)type; }
+    
+    // bind may be null for templates without parameters
+    void define(HazardActionTemplate type, BuildFunction build, BindFunction bind, int prewarm);
+    
+    // The instance isn't autoreleased nor retained for the caller: it must be run (or kept) before the next
+    // one of the same template is asked for, or the same instance may be handed out again
+    cocos2d::Action *instantiate(HazardActionTemplate type, const HazardActionParams &params = HazardActionParams());
+};
+
+#endif /* HazardActionCache_h */
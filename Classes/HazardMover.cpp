@@ -0,0 +1,103 @@
+//
+//  HazardMover.cpp
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#include "HazardMover.h"
+
+using namespace cocos2d;
+
+void HazardMover::add(Node *node, Vec2 velocity, Action *nextAction, ExitDir exitDir, float expansion)
+{
+    auto box = node->getBoundingBox();
+    auto offset = Vec2(box.getMidX(), box.getMidY()) - node->getPosition();
+    
+    nodes.push_back(node);
+    velocities.push_back(velocity);
+    reaches.push_back(offset.length() + Vec2(box.size.width, box.size.height).length()/2);
+    expansions.push_back(expansion);
+    exitDirs.push_back(exitDir);
+    nextActions.push_back(nextAction);
+}
+
+void HazardMover::removeAt(int index)
+{
+    int last = (int)nodes.size() - 1;
+    if (index != last)
+    {
+        nodes[index] = std::move(nodes[last]);
+        velocities[index] = velocities[last];
+        reaches[index] = reaches[last];
+        expansions[index] = expansions[last];
+        exitDirs[index] = exitDirs[last];
+        nextActions[index] = std::move(nextActions[last]);
+    }
+    
+    nodes.pop_back();
+    velocities.pop_back();
+    reaches.pop_back();
+    expansions.pop_back();
+    exitDirs.pop_back();
+    nextActions.pop_back();
+}
+
+void HazardMover::remove(Node *node)
+{
+    for (int i = 0; i < (int)nodes.size(); i++)
+        if (nodes[i] == node)
+        {
+            removeAt(i);
+            return;
+        }
+}
+
+bool HazardMover::getVelocity(Node *node, Vec2 &velocity) const
+{
+    for (int i = 0; i < (int)nodes.size(); i++)
+        if (nodes[i] == node)
+        {
+            velocity = velocities[i];
+            return true;
+        }
+    
+    return false;
+}
+
+const std::vector<HazardMover::Exit> &HazardMover::step(float delta, const Rect &playfield)
+{
+    exits.clear();
+    
+    for (int i = 0; i < (int)nodes.size();)
+    {
+        Node *node = nodes[i];
+        if (node->getParent() == nullptr)
+        {
+            i++;
+            continue;
+        }
+        
+        auto position = node->getPosition() + delta * velocities[i];
+        node->setPosition(position);
+        
+        // Same test as intersecting the bounding box with the expanded playfield, but only on the exit sides
+        float reach = reaches[i] + expansions[i];
+        int exitDir = (int)exitDirs[i];
+        bool inside = true;
+        if ((exitDir & (int)ExitDir::LEFT) && position.x + reach < playfield.getMinX()) inside = false;
+        if ((exitDir & (int)ExitDir::RIGHT) && position.x - reach > playfield.getMaxX()) inside = false;
+        if ((exitDir & (int)ExitDir::BOTTOM) && position.y + reach < playfield.getMinY()) inside = false;
+        if ((exitDir & (int)ExitDir::TOP) && position.y - reach > playfield.getMaxY()) inside = false;
+        
+        if (inside) i++;
+        else
+        {
+            exits.push_back({ nodes[i], nextActions[i] });
+            removeAt(i);
+        }
+    }
+    
+    return exits;
+}
@@ -0,0 +1,66 @@
+//
+//  HazardMover.h
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#ifndef HazardMover_h
+#define HazardMover_h
+
+#include "cocos2d.h"
+#include <vector>
+
+enum class ExitDir : int
+{
+    LEFT = 1,
+    RIGHT = 2,
+    TOP = 4,
+    BOTTOM = 8,
+    ALL = 15
+};
+inline static ExitDir operator|(ExitDir i1, ExitDir i2) { return ExitDir((int)i1 | (int)i2); }
+inline static ExitDir operator&(ExitDir i1, ExitDir i2) { return ExitDir((int)i1 & (int)i2); }
+
+// Moves hazards at constant velocity until they leave the playfield through one of their exit sides, all of
+// them in one loop over parallel arrays instead of a schedule per node. Positions are read back from the
+// nodes every step, so other actions (oscillations, MoveBy...) can still move them at the same time
+class HazardMover
+{
+public:
+    struct Exit
+    {
+        cocos2d::RefPtr<cocos2d::Node> node;
+        cocos2d::RefPtr<cocos2d::Action> nextAction;
+    };
+
+private:
+    std::vector<cocos2d::RefPtr<cocos2d::Node>> nodes;
+    std::vector<cocos2d::Vec2> velocities;
+    std::vector<float> reaches;
+    std::vector<float> expansions;
+    std::vector<ExitDir> exitDirs;
+    std::vector<cocos2d::RefPtr<cocos2d::Action>> nextActions;
+    std::vector<Exit> exits;
+    
+    void removeAt(int index);
+
+public:
+    // The node's bounds are taken once, here, as the farthest its bounding box can reach from its position
+    // under any rotation; shrinking it afterwards only makes it leave a bit later
+    void add(cocos2d::Node *node, cocos2d::Vec2 velocity, cocos2d::Action *nextAction, ExitDir exitDir, float expansion);
+    void remove(cocos2d::Node *node);
+    
+    // False if the node isn't being moved
+    bool getVelocity(cocos2d::Node *node, cocos2d::Vec2 &velocity) const;
+    
+    // Moves every node by delta * velocity (nodes not added anywhere yet are skipped) and takes out the ones
+    // that left the playfield (given in the nodes' parent space), which are returned with their actions.
+    // The result is valid until the next step
+    const std::vector<Exit> &step(float delta, const cocos2d::Rect &playfield);
+    
+    inline int getCount() const { return (int)nodes.size(); }
+};
+
+#endif /* HazardMover_h */
@@ -18,10 +18,7 @@ using namespace cocos2d;
 
 inline static CallFunc *postScore(int value)
 {
-    return CallFunc::create([value] () mutable
-                            {
-                                Director::getInstance()->getEventDispatcher()->dispatchCustomEvent("ScoreUpdate", &value);
-                            });
+    return CallFunc::create([value] { GameEvents::post(GameEvents::ScoreUpdate{value}); });
 }
 
 inline static CallFunc *moveOffscreen(HazardSelector *obj, Vec2 dir, RefPtr<Action> nextAction)
@@ -29,6 +26,58 @@ inline static CallFunc *moveOffscreen(HazardSelector *obj, Vec2 dir, RefPtr<Acti
     return CallFuncN::create([=] (Node *node) { obj->moveHazardOffscreen(node, dir, nextAction); });
 }
 
+// Posts the score, removes the collision and removes the node, in one action whose score and handle can be
+// set again when it's reused from the action cache; no score is posted if it's zero
+class RetireHazard : public ActionInstant
+{
+public:
+    int score = 0;
+    CollisionManager::HazardHandle handle;
+    
+    static RetireHazard *create()
+    {
+        RetireHazard *pRet = new(std::nothrow) RetireHazard();
+        if (pRet)
+        {
+            pRet->autorelease();
+            return pRet;
+        }
+        else return nullptr;
+    }
+    
+    virtual void update(float time) override
+    {
+        if (score != 0) GameEvents::post(GameEvents::ScoreUpdate{score});
+        
+        CollisionManager::removeHazard(handle);
+        _target->removeFromParentAndCleanup(true);
+    }
+};
+
+inline static FiniteTimeAction *retireHazard(HazardSelector *self, int score, CollisionManager::HazardHandle handle)
+{
+    HazardActionParams params;
+    params.score = score;
+    params.handle = handle;
+    return static_cast<FiniteTimeAction*>(self->instantiateAction(HazardActionTemplate::Retire, params));
+}
+
+// The action that carries a hazard along its path, for the hazards restoreHazard can bring back midway
+constexpr int HazardMotionTag = 0x7300;
+
+// Runs the action as if it had been running for the given time already, with the node staying where it is;
+// the movements are stackable, so they carry on from there
+static void resumeAction(Node *node, Action *action, float elapsed)
+{
+    node->runAction(action);
+    if (elapsed <= 0) return;
+    
+    auto position = node->getPosition();
+    action->step(0);
+    action->step(elapsed);
+    node->setPosition(position);
+}
+
 // HAZARD FUNCTIONS
 inline static int genSpriteArray(bool *val, int maxSprites)
 {
@@ -63,12 +112,27 @@ inline static int genSpriteArray(bool *val, int maxSprites)
     return currentCount;
 }
 
-#define RUN_AND_ADD(obj, act) (obj)->runAction(self->addAction(act))
+// A cube of the first spawner's walls, with its oscillation the given time in
+static void addWallCube(HazardSelector *self, Vec2 position, Vec2 velocity, const HazardActionParams &oscillation, float rotation = 0, float oscillationTime = 0)
+{
+    auto sprite = self->acquireSprite(HazardPoolType::Cube);
+    sprite->setPosition(position);
+    sprite->setRotation(rotation);
+    
+    resumeAction(sprite, self->instantiateAction(HazardActionTemplate::CubeOscillate, oscillation), oscillationTime);
+    sprite->runAction(self->instantiateAction(HazardActionTemplate::CubeSpin));
+    
+    CollisionManager::HazardCollisionData::HazardInfo info = { 30, 30, false, true, { nullptr, nullptr } };
+    auto handle = CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircle(sprite, Vec2::ZERO, 20), info);
+    
+    self->moveHazardOffscreen(sprite, velocity, retireHazard(self, 30, handle), ExitDir::LEFT);
+    self->addChild(sprite);
+}
+
 static bool spriteChoices[12];
 void hazardCubeSpawner1(HazardSelector* self)
 {
     constexpr float MoveSpeed = 112.5,
-                    RotateTime = 2.0,
                     PeriodMin = 1.2,
                     PeriodMax = 3.0,
                     AmplitudeMin = 8,
@@ -88,21 +152,13 @@ void hazardCubeSpawner1(HazardSelector* self)
     for (int i = 0; i < maxSprites; i++)
     {
         if (!spriteChoices[i]) continue;
-        auto sprite = Sprite::createWithSpriteFrameName("HazardCube.png");
-        sprite->setPosition(size.width + 24, offset + i*48);
         
-        auto orgY = offset + i*48;
-        auto oscillate = ExecFunc::create(period, [orgY, amplitude] (Node* target, float time)
-                                          { target->setPositionY(orgY + amplitude * sin(2 * M_PI * time)); });
+        HazardActionParams params;
+        params.period = period;
+        params.origin = offset + i*48;
+        params.amplitude = amplitude;
         
-        RUN_AND_ADD(sprite, RepeatForever::create(oscillate));
-        RUN_AND_ADD(sprite, RepeatForever::create(RotateBy::create(RotateTime, 360)));
-        
-        self->moveHazardOffscreen(sprite, Vec2(-MoveSpeed, 0), Sequence::createWithTwoActions(postScore(30), RemoveSelf::create()), ExitDir::LEFT);
-        self->addChild(sprite);
-        
-        CollisionManager::HazardCollisionData::HazardInfo info = { 30, 30, false, true, { nullptr, nullptr } };
-        CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircle(sprite, Vec2::ZERO, 20, info));
+        addWallCube(self, Vec2(size.width + 24, offset + i*48), Vec2(-MoveSpeed, 0), params);
     }
     
     self->spawnTime = 1.0 + 2.0f*float(generatedSprites-1)/(maxSprites-1);
@@ -110,7 +166,7 @@ void hazardCubeSpawner1(HazardSelector* self)
 
 void hazardCubeSpawner2(HazardSelector *self)
 {
-    constexpr float MoveSpeed = 112.5, RotateTime = 2.0f;
+    constexpr float MoveSpeed = 112.5;
     
     const Size &size = self->getPlayfieldSize();
     auto numChains = random_float_closed(0, 1) <= 0.6 ? 2 : 3;
@@ -126,6 +182,7 @@ void hazardCubeSpawner2(HazardSelector *self)
     for (int i = 0; i < numChains-1; i++)
     {
         nodes[i] = BezierNode::create(Color3B(200, 200, 200), 1.5);
+        self->attachToHazardClock(nodes[i]);
         
         nodes[i]->setPosition(size.width + 24, centerY - joinHeight/2 + 42*i + 21);
         nodes[i]->reinputCurve(Vec2(0, -21), Vec2(0, 0), Vec2(0, 21));
@@ -156,13 +213,13 @@ void hazardCubeSpawner2(HazardSelector *self)
             }
             
             CollisionManager::HazardCollisionData::HazardInfo info = { 30, 50, false, true, { nullptr, nullptr } };
-            CollisionManager::addHazard(CollisionManager::HazardCollisionData::createPolygon(node, Vec2(0, 0), points, 10, info, true));
+            CollisionManager::addHazard(CollisionManager::HazardCollisionData::createPolygon(node, Vec2(0, 0), points, 10), info);
         });
         
         auto centerDir = i*(chainHeight-42) + (joinHeight + chainHeight - height)/2 - 21;
         auto spawn = Spawn::create(readjust, MoveBy::create(1, Vec2(0, centerDir)), nullptr);
         
-        RUN_AND_ADD(nodes[i], Sequence::create(DelayTime::create(size.width/5/MoveSpeed), spawn, addBody, nullptr));
+        nodes[i]->runAction(Sequence::create(DelayTime::create(size.width/5/MoveSpeed), spawn, addBody, nullptr));
         
         self->moveHazardOffscreen(nodes[i], Vec2(-MoveSpeed, 0), Sequence::createWithTwoActions(postScore(50), RemoveSelf::create()), ExitDir::LEFT);
         self->addChild(nodes[i]);
@@ -170,24 +227,24 @@ void hazardCubeSpawner2(HazardSelector *self)
     
     for (int i = 0; i < numChains; i++)
     {
-        auto sprite = Sprite::createWithSpriteFrameName("HazardCube.png");
+        auto sprite = self->acquireSprite(HazardPoolType::Cube);
         sprite->setPosition(size.width + 24, centerY - joinHeight/2 + i*42);
 
-        RUN_AND_ADD(sprite, RepeatForever::create(RotateBy::create(RotateTime, 360)));
+        sprite->runAction(self->instantiateAction(HazardActionTemplate::CubeSpin));
         
         if (!(numChains == 3 && i == 1))
         {
             auto dir = i*(chainHeight-42) + (joinHeight - height)/2;
             auto action = EaseSineInOut::create(MoveBy::create(1, Vec2(0, dir)));
             
-            RUN_AND_ADD(sprite, Sequence::create(DelayTime::create(size.width/5/MoveSpeed), action, nullptr));
+            sprite->runAction(Sequence::create(DelayTime::create(size.width/5/MoveSpeed), action, nullptr));
         }
         
-        self->moveHazardOffscreen(sprite, Vec2(-MoveSpeed, 0), Sequence::createWithTwoActions(postScore(30), RemoveSelf::create()), ExitDir::LEFT);
-        self->addChild(sprite);
-        
         CollisionManager::HazardCollisionData::HazardInfo info = { 30, 30, false, true, { i >= 1 ? nodes[i-1] : nullptr, i < numChains-1 ? nodes[i] : nullptr } };
-        CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircle(sprite, Vec2(0, 0), 20, info));
+        auto handle = CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircle(sprite, Vec2(0, 0), 20), info);
+        
+        self->moveHazardOffscreen(sprite, Vec2(-MoveSpeed, 0), retireHazard(self, 30, handle), ExitDir::LEFT);
+        self->addChild(sprite);
     }
     
     self->spawnTime = 0.6 + 0.6*numChains;
@@ -221,6 +278,146 @@ static const Vector<SpriteFrame*> &getShootingFrames()
     return frames;
 }
 
+// The animations are shared by every shooter; only the Animate instances are per spawn
+static Animation *getShooterAnimation()
+{
+    static RefPtr<Animation> animation = Animation::createWithSpriteFrames(getAnimationFrames(), 1.0/60);
+    return animation;
+}
+
+static Animation *getShooterShootingAnimation()
+{
+    static RefPtr<Animation> animation = Animation::createWithSpriteFrames(getShootingFrames(), 1.0/60);
+    return animation;
+}
+
+// Sends the shot it runs on from the shooter towards the player; it finds the shooter and the selector
+// through the scene graph, so the same instance serves every shot
+class FireShooterShot : public ActionInstant
+{
+public:
+    static FireShooterShot *create()
+    {
+        FireShooterShot *pRet = new(std::nothrow) FireShooterShot();
+        if (pRet)
+        {
+            pRet->autorelease();
+            return pRet;
+        }
+        else return nullptr;
+    }
+    
+    virtual void update(float time) override
+    {
+        Node *shot = _target, *node = shot->getParent();
+        HazardSelector *self = static_cast<HazardSelector*>(node->getParent());
+        
+        if (!self->isSilent()) SoundManager::play("common/ShooterSound.wav");
+        
+        auto pos = self->getPlayerPos(Vec2(0, self->worldState.playfieldSize.height/2));
+        
+        auto dir = (pos - node->getPosition()).getNormalized();
+        shot->setPosition(node->getPosition() + dir * 58);
+        
+        // Retained through the move, so it isn't recycled when it leaves the shooter
+        RefPtr<Node> guard = shot;
+        shot->removeFromParent();
+        self->addChild(shot);
+        
+        CollisionManager::HazardCollisionData::HazardInfo info = { 10, -1, false, false, { nullptr, nullptr } };
+        auto handle = CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircle(shot, Vec2::ZERO, 3), info);
+        
+        self->moveHazardOffscreen(shot, dir * 600, retireHazard(self, 50, handle));
+    }
+};
+
+// The whole life of a shooter: it slides in and opens, fires its shots one after the other, closes and is
+// sent offscreen to be retired. A Sequence with a Repeat in the middle, except that the number of shots (and
+// the directions) can be bound again on each spawn, which cocos2d's can't once they're built
+class ShooterRoutine : public Action
+{
+    RefPtr<FiniteTimeAction> enterUp, enterDown, shot, exit;
+    FiniteTimeAction *current = nullptr;
+    int shotsLeft = 0;
+    
+    void begin(FiniteTimeAction *action, float elapsed)
+    {
+        current = action;
+        current->startWithTarget(_target);
+        current->step(0);
+        current->step(elapsed);
+    }
+    
+public:
+    static constexpr float EnterSpeed = 100.0, MoveAmount = 80.0;
+    
+    bool fromBottom = true;
+    int numShots = 1;
+    Vec2 exitVelocity;
+    CollisionManager::HazardHandle handle;
+    
+    static ShooterRoutine *create()
+    {
+        ShooterRoutine *pRet = new(std::nothrow) ShooterRoutine();
+        if (pRet)
+        {
+            auto animate = Animate::create(getShooterAnimation());
+            auto shootingAnimate = Animate::create(getShooterShootingAnimation());
+            
+            pRet->enterUp = Sequence::createWithTwoActions(MoveBy::create(MoveAmount/EnterSpeed, Vec2(0, MoveAmount)), animate);
+            pRet->enterDown = Sequence::createWithTwoActions(MoveBy::create(MoveAmount/EnterSpeed, Vec2(0, -MoveAmount)), animate->clone());
+            
+            auto fire = Sequence::create(DelayTime::create(11.0/64), MoveBy::create(5.0/64, Vec2(-46.875, 0)), FireShooterShot::create(),
+                                         DelayTime::create(0.25), nullptr);
+            pRet->shot = Spawn::createWithTwoActions(RunOnChild::create("ShotNode", fire),
+                                                     Sequence::createWithTwoActions(shootingAnimate, shootingAnimate->reverse()));
+            pRet->exit = animate->reverse();
+            
+            pRet->autorelease();
+            return pRet;
+        }
+        else return nullptr;
+    }
+    
+    virtual void startWithTarget(Node *target) override
+    {
+        Action::startWithTarget(target);
+        shotsLeft = numShots;
+        begin(fromBottom ? enterUp.get() : enterDown.get(), 0);
+    }
+    
+    virtual bool isDone() const override { return current == nullptr; }
+    
+    virtual void step(float delta) override
+    {
+        current->step(delta);
+        
+        // The time past the end of a phase carries over into the next, like in a Sequence
+        while (current && current->isDone())
+        {
+            float overshoot = std::max(static_cast<ActionInterval*>(current)->getElapsed() - current->getDuration(), 0.0f);
+            bool exiting = current == exit.get();
+            current->stop();
+            current = nullptr;
+            
+            if (exiting)
+            {
+                auto self = static_cast<HazardSelector*>(_target->getParent());
+                self->moveHazardOffscreen(_target, exitVelocity, retireHazard(self, 0, handle));
+            }
+            else if (shotsLeft-- > 0) begin(shot.get(), overshoot);
+            else begin(exit.get(), overshoot);
+        }
+    }
+    
+    virtual void stop() override
+    {
+        if (current) current->stop();
+        current = nullptr;
+        Action::stop();
+    }
+};
+
 void hazardShooterSpawner(HazardSelector *self)
 {
     const float probabilities[] = { 1.0, 0.4, 0.1, 0.05, 0.02, 0.004, 0.001, 0.0001 };
@@ -229,95 +426,52 @@ void hazardShooterSpawner(HazardSelector *self)
     const Color3B possibleColors[] = { 0x4CAF50_c3, 0xCDDC39_c3, 0xFFEB3B_c3, 0xFF9800_c3, 0xF44336_c3 };
     constexpr int possibleColorsSize = sizeof(possibleColors)/sizeof(possibleColors[0]);
     
-    constexpr float EnterSpeed = 100.0, MoveAmount = 80.0, ExitSpeed = 180.0;
+    constexpr float ExitSpeed = 180.0;
 
     const Size &size = self->getPlayfieldSize();
     auto fromBottom = random_float_open(0, 1) < 0.5;
     
-    auto animate = Animate::create(Animation::createWithSpriteFrames(getAnimationFrames(), 1.0/60));
-    auto shootingAnimate = Animate::create(Animation::createWithSpriteFrames(getShootingFrames(), 1.0/60));
-    
-    auto node = Sprite::createWithSpriteFrameName("HazardShooter1.png");
+    auto node = self->acquireSprite(HazardPoolType::Shooter);
     node->setAnchorPoint(Vec2(76.0/144, 0.5));
     node->setPosition(random_float_closed(size.width/2, size.width - 40), fromBottom ? -40 : size.height + 40);
     node->setGLProgramState(GLProgramState::getOrCreateWithGLProgramName("ShooterProgram"));
     
-    auto background = Sprite::createWithSpriteFrameName("HazardShooterBackground.png");
-    background->setPosition(18.5, 16);
-    background->setAnchorPoint(node->getAnchorPoint());
-    node->addChild(background, -2);
-    
-    auto playerParent = self->getParent();
     node->schedule([=] (float dt)
     {
-        auto player = playerParent->getChildByName("PlayerNode");
-        auto pos = player ? player->getPosition() : Vec2(0, size.height/2);
+        auto pos = self->getPlayerPos(Vec2(0, size.height/2));
         node->setRotation(180 - CC_RADIANS_TO_DEGREES((pos - node->getPosition()).getAngle()));
     }, "Orient");
     
-    auto move1 = MoveBy::create(MoveAmount/EnterSpeed, Vec2(0, fromBottom ? MoveAmount : -MoveAmount));
-    auto move2 = moveOffscreen(self, Vec2(random_float_open(0, 1) < 0.1 ? -ExitSpeed : ExitSpeed, 0), RemoveSelf::create());
-    
     int numShots = 0;
     {
         float rand = powf(random_float_open(0, 1), self->currentTime/330);
         while (numShots < probabilitiesSize && rand < probabilities[numShots]) numShots++;
     }
     
-    Vector<FiniteTimeAction*> actions(6);
-    actions.pushBack(move1); actions.pushBack(animate);
-    
-    auto dualAnimation = Sequence::create(shootingAnimate, shootingAnimate->reverse(), nullptr);
+    CollisionManager::HazardCollisionData::HazardInfo info = { 40, numShots*80, false, true, { nullptr, nullptr } };
+    auto handle = CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircle(node, Vec2::ZERO, 16), info);
     
+    // The shots wait on the shooter, all under the same name: the routine fires whichever one is left first
     for (int i = 0; i < numShots; i++)
     {
-        auto shotsprite = Sprite::createWithSpriteFrameName("HazardShooterShot.png");
-        shotsprite->setName("ShotNode" + ulongToString(i));
+        auto shotsprite = self->acquireSprite(HazardPoolType::ShooterShot);
+        shotsprite->setName("ShotNode");
         shotsprite->setPosition(18.5, 16);
         shotsprite->setLocalZOrder(-1);
         
         node->addChild(shotsprite);
-        
-        auto spawnProjectile = CallFunc::create([=]
-        {
-            if (!self->onTitle) SoundManager::play("common/ShooterSound.wav");
-            
-            auto pos = self->getPlayerPos(Vec2(0, size.height/2));
-            
-            auto dir = (pos - node->getPosition()).getNormalized();
-            auto newPos = node->getPosition() + dir * 58;
-            
-            shotsprite->setPosition(newPos);
-            shotsprite->retain(); // <---------------------+
-            shotsprite->removeFromParent();             // |
-            node->getParent()->addChild(shotsprite);    // | - safeguard
-            shotsprite->release(); // <--------------------+
-            CollisionManager::HazardCollisionData::HazardInfo info = { 10, -1, false, false, { nullptr, nullptr } };
-            CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircle(shotsprite, Vec2::ZERO, 3, info));
-            
-            self->moveHazardOffscreen(shotsprite, dir * 600, Sequence::createWithTwoActions(postScore(50), RemoveSelf::create()));
-        });
-        
-        auto projDelay = DelayTime::create(11.0/64);
-        auto projMove = MoveBy::create(5.0/64, Vec2(-46.875, 0));
-        auto afterMove = DelayTime::create(0.25);
-        
-        auto seq = RunOnChild::create(shotsprite->getName(), Sequence::create(projDelay, projMove, spawnProjectile, afterMove, nullptr));
-        
-        actions.pushBack(Spawn::createWithTwoActions(seq, dualAnimation));
     }
     node->setColor(possibleColors[std::min(numShots, possibleColorsSize)-1]);
     
-    actions.pushBack(animate->reverse());
-    actions.pushBack(move2);
-    
-    RUN_AND_ADD(node, Sequence::create(actions));
+    HazardActionParams params;
+    params.count = numShots;
+    params.direction = Vec2(0, fromBottom ? 1 : -1);
+    params.velocity = Vec2(random_float_open(0, 1) < 0.1 ? -ExitSpeed : ExitSpeed, 0);
+    params.handle = handle;
+    node->runAction(self->instantiateAction(HazardActionTemplate::Shooter, params));
     
     self->addChild(node);
     
-    CollisionManager::HazardCollisionData::HazardInfo info = { 40, numShots*80, false, true, { nullptr, nullptr } };
-    CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircle(node, Vec2::ZERO, 16, info));
-    
     self->spawnTime = random_float_closed(0.2, 2);
 }
 
@@ -335,35 +489,38 @@ static const Vector<SpriteFrame*> &getJetFireFrames()
     return frames;
 }
 
-void hazardBulletSpawner(HazardSelector *self)
+// A bullet the given time into its flight, which always takes it across the whole playfield
+static Sprite *addBullet(HazardSelector *self, Vec2 position, float flightTime = 0)
 {
     const Size &size = self->getPlayfieldSize();
     
-    auto sprite = Sprite::createWithSpriteFrameName("HazardBullet.png");
-    auto pos = self->getPlayerPos(Vec2(0, size.height/2));
-    
-    float deviation = 120*expf(-self->currentTime/600);
-    sprite->setPosition(size.width+36, random_float_closed(std::max(0.0f, pos.y - deviation), std::min(size.height, pos.y + deviation)));
+    auto sprite = self->acquireSprite(HazardPoolType::Bullet);
+    sprite->setPosition(position);
     
     constexpr float Power = 3.0, Inverse = 1/Power, AccelV = 40;
     auto duration = powf((size.width+72)/AccelV, Inverse);
     auto action = EaseCubicActionIn::create(MoveBy::create(duration, Vec2(-size.width-72, 0)));
     
-    if (!self->onTitle) SoundManager::play("common/BulletFlight.wav");
-    RUN_AND_ADD(sprite, Sequence::create(action, postScore(150), RemoveSelf::create(), nullptr));
-    self->addChild(sprite);
+    CollisionManager::HazardCollisionData::HazardInfo info = { 40, 300, false, true, { nullptr, nullptr } };
+    auto handle = CollisionManager::addHazard(CollisionManager::HazardCollisionData::createTwoOffsetCapsule(sprite, Vec2(-13, 0), Vec2(13, 0), 3), info);
     
-    auto flame = Sprite::createWithSpriteFrameName("JetFire1.png");
-    flame->setPosition(38, 6);
-    flame->setRotation(180);
-    flame->setScale(0.1875);
+    auto flight = Sequence::createWithTwoActions(action, retireHazard(self, 150, handle));
+    flight->setTag(HazardMotionTag);
+    resumeAction(sprite, flight, flightTime);
+    self->addChild(sprite);
     
-    auto animate = Animate::create(Animation::createWithSpriteFrames(getJetFireFrames(), 1.0/30));
-    flame->runAction(RepeatForever::create(animate));
-    sprite->addChild(flame, -1);
+    sprite->getChildByName("JetFlame")->runAction(self->instantiateAction(HazardActionTemplate::JetFlame));
+    return sprite;
+}
+
+void hazardBulletSpawner(HazardSelector *self)
+{
+    const Size &size = self->getPlayfieldSize();
+    auto pos = self->getPlayerPos(Vec2(0, size.height/2));
     
-    CollisionManager::HazardCollisionData::HazardInfo info = { 40, 300, false, true, { nullptr, nullptr } };
-    CollisionManager::addHazard(CollisionManager::HazardCollisionData::createTwoOffsetCapsule(sprite, Vec2(-13, 0), Vec2(13, 0), 3, info));
+    float deviation = 120*expf(-self->currentTime/600);
+    addBullet(self, Vec2(size.width+36, random_float_closed(std::max(0.0f, pos.y - deviation), std::min(size.height, pos.y + deviation))));
+    if (!self->isSilent()) SoundManager::play("common/BulletFlight.wav");
     
     self->spawnTime = 0.2;
 }
@@ -377,63 +534,45 @@ void hazardFireballSpawner(HazardSelector *self)
     
     const Size &size = self->getPlayfieldSize();
     
-    auto sprite = Sprite::createWithSpriteFrameName("HazardFireball.png");
+    auto sprite = self->acquireSprite(HazardPoolType::Fireball);
     sprite->setPosition(size.width + 36, random_float_closed(36, size.height-36));
     
     Vec2 dir(random_float_closed(36, 240) - sprite->getPositionX(), 0);
     auto duration = -dir.x/ShipSpeed;
     
+    // The trail is added after the fireball, so the flames are drawn over it
+    self->addChild(sprite);
+    CollisionManager::HazardCollisionData::HazardInfo flameInfo = { 20, -1, false, false, { nullptr, nullptr } };
+    RefPtr<FlameTrailNode> trail = self->createFlameTrail(flameInfo);
+    
     int numFlames = 0;
     auto move = MoveBy::create(duration, dir);
     auto spawn = CallFunc::create([=] () mutable
     {
         auto dir = Vec2::forAngle(random_float_closed(-.15, .15)) * PrevFlameSpeed;
-        
-        auto sp = Sprite::createWithSpriteFrameName("HazardFireballFlame.png");
-        sp->setPosition(sprite->getPosition());
-        self->moveHazardOffscreen(sp, dir, RemoveSelf::create());
-        
         float duration = MAX(0.0, ShipSpeed/PrevFlameSpeed * numFlames++ * FlameInterval - 1.75);
-        
-        RUN_AND_ADD(sp, Sequence::create(DelayTime::create(duration), TintBy::create(0.6, -8, -22, -129),
-                                         ScaleTo::create(0.4, 0), RemoveSelf::create(), nullptr));
-        
-        self->addChild(sp);
-        
-        CollisionManager::HazardCollisionData::HazardInfo info = { 20, -1, false, false, { nullptr, nullptr } };
-        CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircle(sp, Vec2::ZERO, 7.5, info));
+        trail->emit(sprite->getPosition(), dir, duration);
     });
     
     auto block = CallFunc::create([=]
     {
-        if (!self->onTitle) SoundManager::play("common/FireballSplit.wav");
+        if (!self->isSilent()) SoundManager::play("common/FireballSplit.wav");
         
         auto vector = Vec2::forAngle(2*M_PI/NumFlames);
         Vec2 dir(ExplodeFlameSpeed, 0);
         
         for (int i = 0; i < NumFlames; i++)
         {
-            auto sp = Sprite::createWithSpriteFrameName("HazardFireballFlame.png");
-            sp->setPosition(sprite->getPosition());
-            
-            self->moveHazardOffscreen(sp, dir, RemoveSelf::create());
-            
-            self->addChild(sp);
-            
-            CollisionManager::HazardCollisionData::HazardInfo info = { 20, -1, false, false, { nullptr, nullptr } };
-            CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircle(sp, Vec2::ZERO, 7.5, info));
-            
+            trail->emit(sprite->getPosition(), dir);
             dir = dir.rotate(vector);
         }
     });
     
-    RUN_AND_ADD(sprite, Sequence::create(move, block, postScore(100), RemoveSelf::create(), nullptr));
-    RUN_AND_ADD(sprite, RepeatForever::create(Sequence::createWithTwoActions(DelayTime::create(FlameInterval), spawn)));
-    
-    self->addChild(sprite);
-    
     CollisionManager::HazardCollisionData::HazardInfo info = { 40, 180, false, true, { nullptr, nullptr } };
-    CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircle(sprite, Vec2::ZERO, 12, info));
+    auto handle = CollisionManager::addHazard(CollisionManager::HazardCollisionData::createCircle(sprite, Vec2::ZERO, 12), info);
+    
+    sprite->runAction(Sequence::create(move, block, retireHazard(self, 100, handle), nullptr));
+    sprite->runAction(RepeatForever::create(Sequence::createWithTwoActions(DelayTime::create(FlameInterval), spawn)));
     
     self->spawnTime = random_float_closed(0.2, 1.5);
 }
@@ -445,6 +584,76 @@ static const Vec2 missilePoints[] =
 };
 static constexpr int missilePointsSize = sizeof(missilePoints)/sizeof(missilePoints[0]);
 
+// Turns the missile towards the player while its steering time lasts, and flies it forward until it leaves
+// the playfield; an action instead of a schedule, so the steering time left can be read back for a snapshot
+class SteerMissile : public Action
+{
+public:
+    float time = 1.8;
+    CollisionManager::HazardHandle handle;
+    
+    static SteerMissile *create(CollisionManager::HazardHandle handle, float time)
+    {
+        SteerMissile *pRet = new(std::nothrow) SteerMissile();
+        if (pRet)
+        {
+            pRet->handle = handle;
+            pRet->time = time;
+            pRet->setTag(HazardMotionTag);
+            pRet->autorelease();
+            return pRet;
+        }
+        else return nullptr;
+    }
+    
+    virtual bool isDone() const override { return false; }
+    
+    virtual void step(float delta) override
+    {
+        Node *node = _target;
+        HazardSelector *hzs = static_cast<HazardSelector*>(node->getParent());
+        const Size &size = hzs->worldState.playfieldSize;
+        
+        if (time > 0)
+        {
+            time -= delta;
+            
+            Vec2 pos = hzs->getPlayerPos(Vec2(0, size.height/2));
+            
+            float angle = -CC_RADIANS_TO_DEGREES((pos - node->getPosition()).getAngle());
+            float rotation = node->getRotation();
+            
+            if (angle - rotation > 180) rotation += 360;
+            else if (rotation - angle > 180) rotation -= 360;
+            
+            rotation += 3.0 * delta * (angle - rotation);
+            node->setRotation(rotation);
+        }
+        
+        node->setPosition(node->getPosition() + 250 * delta * Vec2::forAngle(CC_DEGREES_TO_RADIANS(-node->getRotation())));
+        
+        if (!Rect(hzs->scrollOffset - 32, -32, size.width+64, size.height+64).containsPoint(node->getPosition()))
+        {
+            GameEvents::post(GameEvents::ScoreUpdate{100});
+            CollisionManager::removeHazard(handle);
+            node->removeFromParent();
+        }
+    }
+};
+
+static void addMissile(HazardSelector *self, Vec2 position, float rotation, float steeringTime = 1.8)
+{
+    auto sprite = self->acquireSprite(HazardPoolType::Missile);
+    sprite->setPosition(position);
+    sprite->setRotation(rotation);
+    
+    CollisionManager::HazardCollisionData::HazardInfo info = { 20, 160, true, true, { nullptr, nullptr } };
+    auto handle = CollisionManager::addHazard(CollisionManager::HazardCollisionData::createPolygon(sprite, Vec2::ZERO, missilePoints, missilePointsSize), info);
+    
+    sprite->runAction(SteerMissile::create(handle, steeringTime));
+    self->addChild(sprite);
+}
+
 void hazardMissileSpawner(HazardSelector *self)
 {
     const Size &size = self->getPlayfieldSize();
@@ -464,70 +673,150 @@ void hazardMissileSpawner(HazardSelector *self)
     
     if (fromSides) number *= 2;
     
-    class updateFunctor
+    for (int i = 0; i < number; i++)
     {
-        float time;
-        Node *node;
-        
-    public:
-        updateFunctor(Node *node) : node(node), time(1.8) {}
-        
-        void operator()(float dt)
+        if (fromSides) addMissile(self, Vec2(size.width * 0.675 + (i/2) * divisor, i%2 == 0 ? -18 : size.height + 18), (i%2 + 1) * 180 + 90);
+        else addMissile(self, Vec2(size.width + 18, 12 + i * divisor), 180);
+    }
+    
+    self->spawnTime = random_float_closed(1.6, 4);
+}
+
+// SNAPSHOTS
+bool snapshotHazard(const HazardSelector *self, Sprite *sprite, HazardPoolType type, WorldSnapshot::Writer &writer)
+{
+    auto position = sprite->getPosition() - Vec2(self->scrollOffset, 0);
+    
+    switch (type)
+    {
+        case HazardPoolType::Cube:
         {
-            HazardSelector *hzs = static_cast<HazardSelector*>(node->getParent());
-            const Size &size = hzs->getPlayfieldSize();
-            float delta = dt * hzs->speed;
+            // Only the walls' cubes; the chained ones would need their chains, which aren't kept
+            auto action = sprite->getActionByTag(HazardActionCache::getTag(HazardActionTemplate::CubeOscillate));
+            Vec2 velocity;
+            if (!action || !self->getMoverVelocity(sprite, velocity)) return false;
             
-            if (time > 0)
-            {
-                time -= delta;
-                
-                Vec2 pos = hzs->getPlayerPos(Vec2(0, size.height/2));
-                
-                float angle = -CC_RADIANS_TO_DEGREES((pos - node->getPosition()).getAngle());
-                float rotation = node->getRotation();
-                
-                if (angle - rotation > 180) rotation += 360;
-                else if (rotation - angle > 180) rotation -= 360;
-                
-                rotation += 3.0 * delta * (angle - rotation);
-                node->setRotation(rotation);
-            }
+            auto oscillate = static_cast<Oscillate*>(static_cast<RepeatForever*>(action)->getInnerAction());
+            writer.write(HazardRecord::WallCube);
+            writer.write(position);
+            writer.write(sprite->getRotation());
+            writer.write(velocity);
+            writer.write(oscillate->getDuration());
+            writer.write(oscillate->getOrigin());
+            writer.write(oscillate->getAmplitude());
+            writer.write(oscillate->getElapsed());
+            return true;
+        }
+        case HazardPoolType::Bullet:
+        {
+            auto flight = static_cast<ActionInterval*>(sprite->getActionByTag(HazardMotionTag));
+            if (!flight) return false;
             
-            node->setPosition(node->getPosition() + 250 * delta * Vec2::forAngle(CC_DEGREES_TO_RADIANS(-node->getRotation())));
+            writer.write(HazardRecord::Bullet);
+            writer.write(position);
+            writer.write(flight->getElapsed());
+            return true;
+        }
+        case HazardPoolType::Missile:
+        {
+            auto steer = static_cast<SteerMissile*>(sprite->getActionByTag(HazardMotionTag));
+            if (!steer) return false;
             
-            if (!Rect(-32, -32, size.width+64, size.height+64).containsPoint(node->getPosition()))
-            {
-                int value = 100;
-                Director::getInstance()->getEventDispatcher()->dispatchCustomEvent("ScoreUpdate", &value);
-                node->removeFromParent();
-            }
+            writer.write(HazardRecord::Missile);
+            writer.write(position);
+            writer.write(sprite->getRotation());
+            writer.write(steer->time);
+            return true;
         }
-    };
+        default: return false;
+    }
+}
+
+bool restoreHazard(HazardSelector *self, WorldSnapshot::Reader &reader)
+{
+    auto record = reader.read<HazardRecord>();
+    if (!reader.isValid()) return false;
     
-    for (int i = 0; i < number; i++)
+    switch (record)
     {
-        auto sprite = Sprite::createWithSpriteFrameName("HazardGuidedMissile.png");
-        
-        if (fromSides)
+        case HazardRecord::WallCube:
         {
-            sprite->setPosition(size.width * 0.675 + (i/2) * divisor, i%2 == 0 ? -18 : size.height + 18);
-            sprite->setRotation((i%2 + 1) * 180 + 90);
+            auto position = reader.readVec2();
+            auto rotation = reader.read<float>();
+            auto velocity = reader.readVec2();
+            
+            HazardActionParams params;
+            params.period = reader.read<float>();
+            params.origin = reader.read<float>();
+            params.amplitude = reader.read<float>();
+            auto time = reader.read<float>();
+            
+            if (reader.isValid()) addWallCube(self, position, velocity, params, rotation, time);
+            return reader.isValid();
         }
-        else
+        case HazardRecord::Bullet:
         {
-            sprite->setPosition(size.width + 18, 12 + i * divisor);
-            sprite->setRotation(180);
+            auto position = reader.readVec2();
+            auto time = reader.read<float>();
+            
+            if (reader.isValid()) addBullet(self, position, time);
+            return reader.isValid();
         }
-        
-        sprite->schedule(updateFunctor(sprite), "Update");
-        self->addChild(sprite);
-        
-        CollisionManager::HazardCollisionData::HazardInfo info = { 20, 160, true, true, { nullptr, nullptr } };
-        CollisionManager::addHazard(CollisionManager::HazardCollisionData::createPolygon(sprite, Vec2::ZERO, missilePoints, missilePointsSize, info));
+        case HazardRecord::Missile:
+        {
+            auto position = reader.readVec2();
+            auto rotation = reader.read<float>();
+            auto time = reader.read<float>();
+            
+            if (reader.isValid()) addMissile(self, position, rotation, time);
+            return reader.isValid();
+        }
+        default: return false;
     }
+}
+
+// ACTION TEMPLATES
+void defineHazardActionTemplates(HazardActionCache &cache)
+{
+    constexpr float CubeRotateTime = 2.0;
     
-    self->spawnTime = random_float_closed(1.6, 4);
+    cache.define(HazardActionTemplate::CubeSpin, [] () -> Action*
+    {
+        return RepeatForever::create(RotateBy::create(CubeRotateTime, 360));
+    }, nullptr, 24);
+    
+    cache.define(HazardActionTemplate::CubeOscillate, [] () -> Action*
+    {
+        return RepeatForever::create(Oscillate::create(1, 0, 0));
+    }, [] (Action *action, const HazardActionParams &params)
+    {
+        auto oscillate = static_cast<Oscillate*>(static_cast<RepeatForever*>(action)->getInnerAction());
+        oscillate->setOscillation(params.period, params.origin, params.amplitude);
+    }, 24);
+    
+    cache.define(HazardActionTemplate::Retire, [] () -> Action* { return RetireHazard::create(); },
+    [] (Action *action, const HazardActionParams &params)
+    {
+        auto retire = static_cast<RetireHazard*>(action);
+        retire->score = params.score;
+        retire->handle = params.handle;
+    }, 40);
+    
+    cache.define(HazardActionTemplate::JetFlame, [] () -> Action*
+    {
+        static RefPtr<Animation> animation = Animation::createWithSpriteFrames(getJetFireFrames(), 1.0/30);
+        return RepeatForever::create(Animate::create(animation));
+    }, nullptr, 4);
+    
+    cache.define(HazardActionTemplate::Shooter, [] () -> Action* { return ShooterRoutine::create(); },
+    [] (Action *action, const HazardActionParams &params)
+    {
+        auto routine = static_cast<ShooterRoutine*>(action);
+        routine->fromBottom = params.direction.y > 0;
+        routine->numShots = params.count;
+        routine->exitVelocity = params.velocity;
+        routine->handle = params.handle;
+    }, 4);
 }
 
 // HAZARD DECLARATION
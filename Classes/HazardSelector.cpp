@@ -15,35 +15,76 @@ using namespace cocos2d;
 
 float global_AdvanceSpeed = 0.0f;
 float global_GameTime = 0.0f;
+std::mt19937 *global_HazardRandomEngine = nullptr;
+
+// Pooled sprites are recognized by their tag, which the spawners don't use otherwise
+constexpr int PooledSpriteTag = 0x7000;
+
+static const char *const pooledSpriteFrames[] =
+{
+    "HazardCube.png", "HazardShooter1.png", "HazardShooterShot.png", "HazardBullet.png",
+    "HazardFireball.png", "HazardGuidedMissile.png"
+};
+
+// How many sprites of each kind are created up front, about as many as a dense phase has alive at once
+static const int pooledSpritePrewarm[] = { 24, 2, 8, 4, 2, 8 };
+
+void HazardWorldState::refresh(Node *player, const Size &playfieldSize, float difficultySpeed, float delta)
+{
+    bool hadPlayer = hasPlayer;
+    hasPlayer = player && player->getParent();
+    
+    if (hasPlayer)
+    {
+        auto position = player->getPosition();
+        playerVelocity = hadPlayer && delta > 0 ? (position - playerPosition)/delta : Vec2::ZERO;
+        playerPosition = position;
+    }
+    else playerVelocity = Vec2::ZERO;
+    
+    this->playfieldSize = playfieldSize;
+    this->difficultySpeed = difficultySpeed;
+    advanceSpeed = global_AdvanceSpeed;
+}
 
 bool HazardSelector::init(bool onTitle)
 {
     if (!Node::init())
         return false;
     
-    spawnTime = 5.0;
-    currentTime = 0.0;
-	global_GameTime = 0.0;
-    speed = 1.0;
-    global_AdvanceSpeed = 0.0f;
+    this->onTitle = onTitle;
     
-    enterDelay = -1.0;
-    currentChosen = -1;
+    hazardScheduler = new(std::nothrow) Scheduler();
+    hazardActionManager = new(std::nothrow) ActionManager();
+    hazardScheduler->scheduleUpdate(hazardActionManager, Scheduler::PRIORITY_SYSTEM, false);
+    hazardScheduler->schedule([this] (float dt) { updateMovers(dt); }, this, 0, false, "Movers");
+
+    simulated = false;
+    spawnCounts.assign(hazardSpawnerSize, 0);
+    worldState.playfieldSize = getPlayfieldSize();
     
-    this->onTitle = onTitle;
-    isArtificialAdvance = false;
+    for (int i = 0; i < (int)HazardPoolType::Count; i++)
+        for (int j = 0; j < pooledSpritePrewarm[i]; j++)
+            spritePools[i].pushBack(createPooledSprite(HazardPoolType(i)));
+    defineHazardActionTemplates(actionCache);
     
     actualProbabilities.resize(hazardSpawnerSize);
-    for (int i = 0; i < hazardSpawnerSize; i++)
-        actualProbabilities[i] = hazardSpawners[i].probability;
-    paused = false;
+    reset();
     
     setName("HazardSelector");
     
     _eventDispatcher->dispatchCustomEvent("HazardSelectorAvailable");
-    triggerAdvancePowerupListener = _eventDispatcher->addCustomEventListener("TriggerAdvancePowerup", CC_CALLBACK_1(HazardSelector::triggerAdvancePowerup, this));
+    triggerAdvancePowerupListener = GameEvents::subscribe<GameEvents::AdvancePowerup>(CC_CALLBACK_1(HazardSelector::triggerAdvancePowerup, this));
     
-    scheduleUpdate();
+    interpolation = 0;
+    if (onTitle)
+    {
+        schedule([this] (float dt)
+        {
+            for (int ticks = titleTimestep.advance(dt); ticks > 0; ticks--) tick(titleTimestep.getStep());
+            interpolation = titleTimestep.getAlpha();
+        }, "HazardClock");
+    }
     
     return true;
 }
@@ -55,8 +96,9 @@ void HazardSelector::update(float delta)
     speed = 1 + currentTime/1080;
     if (onTitle) speed *= 0.5;
     currentTime += delta * speed;
+    hazardScheduler->setTimeScale(speed);
     
-	if (!onTitle)
+	if (!isSilent())
 	{
 		int oldMin = global_GameTime / 60;
 		global_GameTime += delta;
@@ -65,19 +107,7 @@ void HazardSelector::update(float delta)
 		if (oldMin != newMin) AchievementManager::updateStat("GameTime", newMin);
 	}
 
-    for (auto it = runningActions.begin(); it != runningActions.end();)
-    {
-        if ((*it)->isDone())
-        {
-            (*it)->release();
-            it = runningActions.erase(it);
-        }
-        else (*it++)->setSpeed(speed);
-    }
-    
-    if (global_AdvanceSpeed > 0)
-        for (Node *value : getChildren())
-            value->setPositionX(value->getPositionX() - delta * global_AdvanceSpeed);
+    scrollWorld(delta);
     
     if (enterDelay >= 0)
     {
@@ -85,9 +115,15 @@ void HazardSelector::update(float delta)
         
         if (enterDelay <= 0)
         {
-            log("Hazard spawned: %d at time %g!", currentChosen, currentTime);
+            if (!simulated) log("Hazard spawned: %d at time %g!", currentChosen, currentTime);
             
+            // Spawners place hazards in playfield coordinates; the new ones are moved to where it's scrolled to
+            ssize_t firstSpawned = getChildrenCount();
             hazardSpawners[currentChosen].function(this);
+            if (scrollOffset != 0)
+                for (ssize_t i = firstSpawned; i < getChildrenCount(); i++)
+                    _children.at(i)->setPositionX(_children.at(i)->getPositionX() + scrollOffset);
+            spawnCounts[currentChosen]++;
             presentHazard(currentChosen);
         }
     }
@@ -128,6 +164,42 @@ void HazardSelector::update(float delta)
     }
 }
 
+void HazardSelector::tick(float step)
+{
+    update(step);
+    hazardScheduler->update(step);
+    
+    interpolator.beginTick();
+    for (Node *child : _children) interpolator.add(child);
+    interpolator.endTick();
+    
+    tickScrollOffsets[0] = tickScrollOffsets[1];
+    tickScrollOffsets[1] = scrollOffset;
+}
+
+void HazardSelector::visit(Renderer *renderer, const Mat4 &parentTransform, uint32_t parentFlags)
+{
+    // The scroll is only smoothed while it moves; it jumps back to 0 when it's folded into the hazards
+    float scrolled = tickScrollOffsets[1] - tickScrollOffsets[0];
+    bool scrolling = scrollOffset == tickScrollOffsets[1] && scrolled > 0;
+    if (scrolling) setPositionX(-(tickScrollOffsets[0] + interpolation * scrolled));
+    
+    interpolator.apply(interpolation);
+    Node::visit(renderer, parentTransform, parentFlags);
+    interpolator.restore();
+    
+    if (scrolling) setPositionX(-scrollOffset);
+}
+
+void HazardSelector::advanceClock(float time)
+{
+    // update() integrates currentTime' = k * (1 + currentTime/1080), k being 0.5 on the title and 1 otherwise
+    float factor = onTitle ? 0.5f : 1.0f;
+    currentTime = (currentTime + 1080) * expf(factor * time / 1080) - 1080;
+    speed = factor * (1 + currentTime/1080);
+    hazardScheduler->setTimeScale(speed);
+}
+
 void HazardSelector::onExitTransitionDidStart()
 {
     Node::onExitTransitionDidStart();
@@ -142,11 +214,13 @@ void HazardSelector::onEnterTransitionDidFinish()
 
 HazardSelector::~HazardSelector()
 {
-    for (auto action : runningActions) action->release();
-    _eventDispatcher->removeEventListener(triggerAdvancePowerupListener);
+    hazardScheduler->unscheduleAll();
+    hazardActionManager->release();
+    hazardScheduler->release();
+    GameEvents::unsubscribe<GameEvents::AdvancePowerup>(triggerAdvancePowerupListener);
 }
 
-void HazardSelector::triggerAdvancePowerup(EventCustom*)
+void HazardSelector::triggerAdvancePowerup(const GameEvents::AdvancePowerup&)
 {
     auto slow = ExecFunc::create(1.0, [](Node *node, float time) { global_AdvanceSpeed = 1500*time; });
     auto speed = ExecFunc::create(1.0, [](Node *node, float time) { global_AdvanceSpeed = 1500*(1 - time); });
@@ -162,46 +236,225 @@ void HazardSelector::triggerAdvancePowerup(EventCustom*)
 
 void HazardSelector::presentHazard(int id)
 {
-    if (onTitle) return;
-    if (getParent()->getChildByName("PlayerNode") == nullptr) return;
+    if (isSilent()) return;
+    if (!worldState.hasPlayer) return;
     
     int index = UserDefault::getInstance()->getIntegerForKey("PresentedHazards");
     if ((index & (1 << id)) == 0)
     {
-        std::string str = hazardStrings[id];
-        _eventDispatcher->dispatchCustomEvent("TutorialMessage", &str);
+        GameEvents::post(GameEvents::TutorialMessage{hazardStrings[id]});
         UserDefault::getInstance()->setIntegerForKey("PresentedHazards", index | (1 << id));
     }
 }
 
-void HazardSelector::moveHazardOffscreen(RefPtr<Node> node, Vec2 dir, RefPtr<Action> nextAction, ExitDir exitDir, float expansion)
+// Sprites are built with the children that don't change between spawns; everything else is set by the spawners
+Sprite *HazardSelector::createPooledSprite(HazardPoolType type)
 {
-    //RefPtr<Action> nextActionPtr = nextAction;
+    auto sprite = Sprite::createWithSpriteFrameName(pooledSpriteFrames[(int)type]);
+    sprite->setTag(PooledSpriteTag + (int)type);
+    attachToHazardClock(sprite);
     
-    auto schedule = [=] (float dt)
+    if (type == HazardPoolType::Shooter)
     {
-        if (node->getParent() == nullptr) return;
-        node->setPosition(node->getPosition() + dt * speed * dir);
-        
-        const Size &screenSize = getPlayfieldSize();
-        
-        // If the rect that contains the entire screen doesn't intersect with the rect that contains the object (transformed to world coordinates),
-        // the object is offscreen and the action is done
-        
-        Rect screenRect(-expansion, -expansion, screenSize.width + 2*expansion, screenSize.height + 2*expansion);
-		Rect transformedObjectRect = node->getBoundingBox();
+        auto background = Sprite::createWithSpriteFrameName("HazardShooterBackground.png");
+        background->setPosition(18.5, 16);
+        background->setAnchorPoint(Vec2(76.0/144, 0.5));
+        sprite->addChild(background, -2);
+    }
+    else if (type == HazardPoolType::Bullet)
+    {
+        auto flame = Sprite::createWithSpriteFrameName("JetFire1.png");
+        flame->setName("JetFlame");
+        flame->setPosition(38, 6);
+        flame->setRotation(180);
+        flame->setScale(0.1875);
+        sprite->addChild(flame, -1);
+    }
+    
+    return sprite;
+}
+
+Sprite *HazardSelector::acquireSprite(HazardPoolType type)
+{
+    auto &pool = spritePools[(int)type];
+    if (pool.empty()) return createPooledSprite(type);
+    
+    // Handed out autoreleased, like a newly created one
+    auto sprite = pool.back();
+    sprite->retain();
+    sprite->autorelease();
+    pool.popBack();
+    
+    sprite->setSpriteFrame(pooledSpriteFrames[(int)type]);
+    sprite->setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP));
+    sprite->setPosition(Vec2::ZERO);
+    sprite->setAnchorPoint(Vec2::ANCHOR_MIDDLE);
+    sprite->setRotation(0);
+    sprite->setScale(1);
+    sprite->setColor(Color3B::WHITE);
+    sprite->setOpacity(255);
+    sprite->setVisible(true);
+    sprite->setLocalZOrder(0);
+    sprite->setName("");
+    
+    return sprite;
+}
+
+void HazardSelector::attachToHazardClock(Node *node)
+{
+    node->setScheduler(hazardScheduler);
+    node->setActionManager(hazardActionManager);
+}
+
+void HazardSelector::recycleSprite(Sprite *sprite, HazardPoolType type)
+{
+    spritePools[(int)type].pushBack(sprite);
+    
+    // The shots a shooter didn't fire are still its children
+    if (type == HazardPoolType::Shooter)
+    {
+        for (auto child : Vector<Node*>(sprite->getChildren()))
+            if (child->getTag() == PooledSpriteTag + (int)HazardPoolType::ShooterShot)
+            {
+                recycleSprite(static_cast<Sprite*>(child), HazardPoolType::ShooterShot);
+                sprite->removeChild(child, true);
+            }
+    }
+}
+
+void HazardSelector::removeChild(Node *child, bool cleanup)
+{
+    if (child->getParent() == this)
+    {
+        mover.remove(child);
         
-        // Use a special intersection algorithm
-        bool intersects = true;
-        if (int(exitDir & ExitDir::LEFT) && transformedObjectRect.getMaxX() < screenRect.getMinX()) intersects = false;
-        if (int(exitDir & ExitDir::RIGHT) && transformedObjectRect.getMinX() > screenRect.getMaxX()) intersects = false;
-        if (int(exitDir & ExitDir::BOTTOM) && transformedObjectRect.getMaxY() < screenRect.getMinY()) intersects = false;
-        if (int(exitDir & ExitDir::TOP) && transformedObjectRect.getMinY() > screenRect.getMaxY()) intersects = false;
+        auto trail = std::find(flameTrails.begin(), flameTrails.end(), child);
+        if (trail != flameTrails.end())
+        {
+            CollisionManager::removeHazard((*trail)->getHazardHandle());
+            flameTrails.erase(trail);
+        }
+    }
+    
+    int type = child->getTag() - PooledSpriteTag;
+    if (type < 0 || type >= (int)HazardPoolType::Count || child->getParent() != this)
+    {
+        Node::removeChild(child, cleanup);
+        return;
+    }
+    
+    // Always cleaned up, since it will come back as another hazard
+    recycleSprite(static_cast<Sprite*>(child), HazardPoolType(type));
+    Node::removeChild(child, true);
+}
+
+void HazardSelector::moveHazardOffscreen(RefPtr<Node> node, Vec2 dir, RefPtr<Action> nextAction, ExitDir exitDir, float expansion)
+{
+    mover.add(node, dir, nextAction, exitDir, expansion);
+}
+
+FlameTrailNode *HazardSelector::createFlameTrail(const CollisionManager::HazardCollisionData::HazardInfo &info)
+{
+    auto trail = FlameTrailNode::create(info);
+    addChild(trail);
+    flameTrails.pushBack(trail);
+    return trail;
+}
+
+void HazardSelector::reset()
+{
+    // The Advance powerup's ramp, if it's running
+    stopAllActions();
+    
+    // One by one, since removeAllChildren skips removeChild, which is what takes them out of the mover and the pools
+    while (!_children.empty()) removeChild(_children.back());
+    
+    spawnTime = 5.0;
+    currentTime = 0.0;
+	global_GameTime = 0.0;
+    speed = 1.0;
+    global_AdvanceSpeed = 0.0f;
+    scrollOffset = 0;
+    tickScrollOffsets[0] = tickScrollOffsets[1] = 0;
+    setPositionX(0);
+    interpolator.clear();
+    hazardScheduler->setTimeScale(speed);
+    
+    enterDelay = -1.0;
+    currentChosen = -1;
+    
+    for (int i = 0; i < hazardSpawnerSize; i++)
+        actualProbabilities[i] = hazardSpawners[i].probability;
+    worldState.hasPlayer = false;
+    paused = false;
+}
+
+void HazardSelector::saveSnapshot(WorldSnapshot::Writer &writer) const
+{
+    writer.write(currentTime);
+    writer.write(speed);
+    writer.write(spawnTime);
+    writer.write(enterDelay);
+    writer.write(int32_t(currentChosen));
+    writer.write(global_GameTime);
+    
+    writer.write(uint8_t(actualProbabilities.size()));
+    for (float probability : actualProbabilities) writer.write(probability);
+    
+    for (Node *child : _children)
+    {
+        int type = child->getTag() - PooledSpriteTag;
+        if (type >= 0 && type < (int)HazardPoolType::Count)
+            snapshotHazard(this, static_cast<Sprite*>(child), HazardPoolType(type), writer);
+    }
+    writer.write(HazardRecord::End);
+}
+
+bool HazardSelector::restoreSnapshot(WorldSnapshot::Reader &reader)
+{
+    currentTime = reader.read<float>();
+    speed = reader.read<float>();
+    spawnTime = reader.read<float>();
+    enterDelay = reader.read<float>();
+    currentChosen = reader.read<int32_t>();
+    global_GameTime = reader.read<float>();
+    hazardScheduler->setTimeScale(speed);
+    
+    // Written by another build with other spawners
+    if (reader.read<uint8_t>() != actualProbabilities.size()) return false;
+    for (float &probability : actualProbabilities) probability = reader.read<float>();
+    
+    while (restoreHazard(this, reader));
+    return reader.isValid() && currentChosen < hazardSpawnerSize;
+}
+
+void HazardSelector::scrollWorld(float delta)
+{
+    if (global_AdvanceSpeed > 0)
+    {
+        scrollOffset += delta * global_AdvanceSpeed;
+        setPositionX(-scrollOffset);
+    }
+    else if (scrollOffset != 0)
+    {
+        // Folded back once the powerup is over, so the offset doesn't keep growing from one powerup to the next;
+        // nothing moves on screen, and the running MoveBy's follow since they're stackable
+        for (Node *child : getChildren())
+            child->setPositionX(child->getPositionX() - scrollOffset);
         
-        if (!intersects)
-            node->runAction(addAction(nextAction));
-    };
+        scrollOffset = 0;
+        setPositionX(0);
+    }
+}
+
+void HazardSelector::updateMovers(float delta)
+{
+    auto playfield = getVisiblePlayfield();
+    for (const auto &exit : mover.step(delta, playfield))
+        exit.node->runAction(exit.nextAction);
     
-    if (isArtificialAdvance) runningScheduledFunctions.push_back(schedule);
-    node->schedule(schedule, "MoveOffscreen");
+    // Backwards, since finished trails leave the list as they're removed
+    for (int i = (int)flameTrails.size()-1; i >= 0; i--)
+        if (!flameTrails.at(i)->step(delta, playfield))
+            flameTrails.at(i)->removeFromParent();
 }
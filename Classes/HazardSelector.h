@@ -11,74 +11,157 @@
 
 #include "cocos2d.h"
 #include "Defaults.h"
+#include "HazardMover.h"
+#include "FlameTrailNode.h"
+#include "HazardActionCache.h"
+#include "GameEvents.h"
+#include "WorldSnapshot.h"
+#include "FixedTimestep.h"
+#include <random>
 
-enum class ExitDir : int
+// The kinds of hazard sprites HazardSelector keeps pools of (see acquireSprite)
+enum class HazardPoolType : int
 {
-    LEFT = 1,
-    RIGHT = 2,
-    TOP = 4,
-    BOTTOM = 8,
-    ALL = 15
+    Cube, Shooter, ShooterShot, Bullet, Fireball, Missile, Count
+};
+
+// The kinds of hazards a snapshot keeps, each written with what it needs to be built again midway (see snapshotHazard)
+enum class HazardRecord : uint8_t
+{
+    End, WallCube, Bullet, Missile
+};
+
+// What the hazards' AI knows about the world, filled once per frame by whoever owns the player (the GameScene,
+// or the simulator) so hazards don't look the player up by name every frame. On the title there's no player
+struct HazardWorldState
+{
+    cocos2d::Vec2 playerPosition, playerVelocity;
+    bool hasPlayer = false;
+    cocos2d::Size playfieldSize;
+    float difficultySpeed = 1, advanceSpeed = 0;
+    
+    // The player may be null or already removed; the velocity is measured from the previous refresh
+    void refresh(cocos2d::Node *player, const cocos2d::Size &playfieldSize, float difficultySpeed, float delta);
 };
-inline static ExitDir operator|(ExitDir i1, ExitDir i2) { return ExitDir((int)i1 | (int)i2); }
-inline static ExitDir operator&(ExitDir i1, ExitDir i2) { return ExitDir((int)i1 & (int)i2); }
 
 class HazardSelector : public cocos2d::Node
 {
     bool paused;
-    std::list<cocos2d::Speed*> runningActions;
-    std::vector<std::function<void(float)>> runningScheduledFunctions;
+    cocos2d::Scheduler *hazardScheduler;
+    cocos2d::ActionManager *hazardActionManager;
+    HazardMover mover;
+    HazardActionCache actionCache;
+    cocos2d::Vector<FlameTrailNode*> flameTrails;
+    cocos2d::Vector<cocos2d::Sprite*> spritePools[(int)HazardPoolType::Count];
     std::vector<float> actualProbabilities;
-    cocos2d::EventListenerCustom *triggerAdvancePowerupListener;
-    bool isArtificialAdvance;
+    GameEvents::ListenerId triggerAdvancePowerupListener;
+    
+    // The hazards are drawn between their last two ticks; the scroll is too, as the selector's own position
+    TransformInterpolator interpolator;
+    float tickScrollOffsets[2];
+    float interpolation;
+    FixedTimestep titleTimestep;
     
     int currentChosen;
     float enterDelay;
     
     bool init(bool onTitle = false);
     
+    cocos2d::Sprite *createPooledSprite(HazardPoolType type);
+    void recycleSprite(cocos2d::Sprite *sprite, HazardPoolType type);
+    void updateMovers(float delta);
+    void scrollWorld(float delta);
+    
 public:
     virtual ~HazardSelector();
     
     virtual void update(float delta) override;
+    virtual void visit(cocos2d::Renderer *renderer, const cocos2d::Mat4 &parentTransform, uint32_t parentFlags) override;
     virtual void onExitTransitionDidStart() override;
     virtual void onEnterTransitionDidFinish() override;
     
-    void triggerAdvancePowerup(cocos2d::EventCustom *event);
+    // Children leave the mover, and pooled sprites go back to their pool, here, whichever way they're removed (RemoveSelf, removeFromParent...)
+    virtual void removeChild(cocos2d::Node *child, bool cleanup = true) override;
+    
+    void triggerAdvancePowerup(const GameEvents::AdvancePowerup &event);
+    
+    // Back to the start of a game: the hazards go back to their pools, and the difficulty clock and the spawn
+    // probabilities are rewound. Their collision records must be cleared beforehand
+    void reset();
     void presentHazard(int id);
+    
+    // A sprite of the type, recycled if the pool has one, reset to how it was just after being created and
+    // not added anywhere yet. It's recycled once it's removed from the selector, so its collision record
+    // must be removed by then; all the paths that take a hazard out of the game already do
+    cocos2d::Sprite *acquireSprite(HazardPoolType type);
+    
+    // Puts the node on the hazard clock: a scheduler and action manager of the selector's own, which run at the
+    // difficulty speed. It must be done before the node runs any action or schedules anything, since those are
+    // dropped when it changes clocks. Pooled sprites are already on it
+    void attachToHazardClock(cocos2d::Node *node);
+    
+    // An instance of the template with the parameters bound, from the selector's cache; see HazardActionCache::instantiate
+    inline cocos2d::Action *instantiateAction(HazardActionTemplate type, const HazardActionParams &params = HazardActionParams())
+    {
+        return actionCache.instantiate(type, params);
+    }
+    
+    // An empty trail, already added; it's stepped along with the mover and removed once it's done
+    FlameTrailNode *createFlameTrail(const CollisionManager::HazardCollisionData::HazardInfo &info);
+    
     void moveHazardOffscreen(cocos2d::RefPtr<cocos2d::Node> node, cocos2d::Vec2 dir, cocos2d::RefPtr<cocos2d::Action> nextAction, ExitDir exitDir = ExitDir::ALL, float expansion = 0);
+    inline bool getMoverVelocity(cocos2d::Node *node, cocos2d::Vec2 &velocity) const { return mover.getVelocity(node, velocity); }
+    
+    // The difficulty clock, the spawn state and the hazards that can be built again midway; the others (shooters,
+    // chains, fireballs and their trails) are left out, and are simply not there when it's restored. The positions
+    // are kept unscrolled, and restoring expects a selector that was just reset
+    void saveSnapshot(WorldSnapshot::Writer &writer) const;
+    bool restoreSnapshot(WorldSnapshot::Reader &reader);
     
     float spawnTime, currentTime;
+    HazardWorldState worldState;
+    
+    // How far the Advance powerup has scrolled the hazards to the left. It's applied once, as the selector's
+    // own position, so the hazards keep their positions and the playfield is seen from scrollOffset onwards
+    // in the selector's space; it's folded back into the hazards once the powerup ends
+    float scrollOffset;
     float speed;
     
     bool onTitle;
     
-    inline void artificiallyAdvance(int numFrames)
-    {
-        isArtificialAdvance = true;
-        while (numFrames--)
-        {
-            update(0.016f);
-            for (auto action : runningActions) action->step(0.016f);
-            for (auto function : runningScheduledFunctions) function(0.016f);
-        }
-        isArtificialAdvance = false;
-        runningScheduledFunctions.clear();
-    }
+    // Set by HazardSimulator: no sounds, tutorial messages, logs or achievement stats
+    bool simulated;
+    std::vector<int> spawnCounts; // how many times each entry of hazardSpawners was spawned
+    
+    inline bool isSilent() const { return onTitle || simulated; }
+    
+    // Moves the difficulty clock (currentTime and speed) to where it would be after the given seconds of play,
+    // in closed form; nothing is spawned or moved
+    void advanceClock(float time);
     
-    inline cocos2d::Vec2 getPlayerPos(cocos2d::Vec2 def)
+    // One fixed tick of play: spawning, then the hazard clock. On the title the selector ticks itself; in a game
+    // the scene ticks it along with the player and the collisions, and the simulator does the same
+    void tick(float step);
+    
+    // Where the hazards are drawn between their last two ticks, from 0 to 1; set by whoever ticks the selector
+    inline void setInterpolation(float alpha) { interpolation = alpha; }
+    
+    // Runs the given frames of play right away, through the hazard clock like in the scene; the selector
+    // is entered meanwhile if it isn't running, since its hazards wouldn't move otherwise
+    inline void artificiallyAdvance(int numFrames)
     {
-        auto player = getParent()->getChildByName("PlayerNode");
-        if (player) return player->getPosition();
-        return def;
+        bool wasRunning = _running;
+        if (!wasRunning) onEnter();
+        
+        while (numFrames--) tick(0.016f);
+        
+        if (!wasRunning) onExit();
     }
     
-    inline cocos2d::Speed* addAction(cocos2d::Action* action)
+    // In the selector's space, like the hazards; def is in playfield coordinates
+    inline cocos2d::Vec2 getPlayerPos(cocos2d::Vec2 def) const
     {
-        auto result = cocos2d::Speed::create(action, speed);
-        result->retain();
-        runningActions.push_back(result);
-        return result;
+        return (worldState.hasPlayer ? worldState.playerPosition : def) + cocos2d::Vec2(scrollOffset, 0);
     }
     
     inline cocos2d::Size getPlayfieldSize()
@@ -87,6 +170,12 @@ public:
         return cocos2d::Size(size.width/size.height * StandardPlayfieldHeight, StandardPlayfieldHeight);
     }
     
+    // The part of the selector's space that is on the playfield
+    inline cocos2d::Rect getVisiblePlayfield()
+    {
+        return cocos2d::Rect(cocos2d::Vec2(scrollOffset, 0), getPlayfieldSize());
+    }
+    
     static HazardSelector* create(bool onTitle = false)
     {
         HazardSelector *pRet = new(std::nothrow) HazardSelector();
@@ -104,30 +193,46 @@ public:
     }
 };
 
+// When set, the random_* helpers draw from this generator instead of cocos2d's global one, so a seeded
+// simulation replays exactly the same spawns (see HazardSimulator)
+extern std::mt19937 *global_HazardRandomEngine;
+
 inline static int random_int_open(int start, int end)
 {
     if (start > end) std::swap(start, end);
+    if (global_HazardRandomEngine) return std::uniform_int_distribution<int>(start, end-1)(*global_HazardRandomEngine);
     return cocos2d::random<int>(start, end-1);
 }
 
 inline static int random_int_closed(int start, int end)
 {
     if (start > end) std::swap(start, end);
+    if (global_HazardRandomEngine) return std::uniform_int_distribution<int>(start, end)(*global_HazardRandomEngine);
     return cocos2d::random<int>(start, end);
 }
 
 inline static float random_float_open(float start, float end)
 {
     if (start > end) std::swap(start, end);
+    if (global_HazardRandomEngine) return std::uniform_real_distribution<float>(start, end)(*global_HazardRandomEngine);
     return cocos2d::random<float>(start, end);
 }
 
 inline static float random_float_closed(float start, float end)
 {
     if (start > end) std::swap(start, end);
+    if (global_HazardRandomEngine) return std::uniform_real_distribution<float>(start, std::nextafter(end, end+1))(*global_HazardRandomEngine);
     return cocos2d::random<float>(start, std::nextafter(end, end+1));
 }
 
+// Defined along with the spawners, which are the ones that use them
+void defineHazardActionTemplates(HazardActionCache &cache);
+
+// Write the hazard as a record (false if it isn't of a kind that's kept), and read one back into the selector
+// (false at the end record)
+bool snapshotHazard(const HazardSelector *self, cocos2d::Sprite *sprite, HazardPoolType type, WorldSnapshot::Writer &writer);
+bool restoreHazard(HazardSelector *self, WorldSnapshot::Reader &reader);
+
 extern const struct HazardSpawner { void (*function)(HazardSelector*); float probability, entranceTime, enterDelay; } hazardSpawners[];
 extern const std::string hazardStrings[];
 extern const int hazardSpawnerSize;
@@ -0,0 +1,182 @@
+//
+//  HazardSimulator.cpp
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#include "HazardSimulator.h"
+#include "HazardSelector.h"
+#include "CollisionManager.h"
+#include "PlayerNode.h"
+#include "ShipConfig.h"
+#include <chrono>
+
+using namespace cocos2d;
+
+namespace HazardSimulator
+{
+    // Mirrors PlayerNode::takeDamage, without the effects
+    struct StandInPlayer
+    {
+        int health = MaxHealth;
+        float invulnerableTime = 0;
+        float firstDeathTime = -1;
+        int deaths = 0;
+        
+        void takeDamage(CollisionManager::HazardHandle handle, const CollisionManager::HazardCollisionData &hazard,
+                        const CollisionManager::HazardCollisionData::HazardInfo &info, float time)
+        {
+            bool canHit = invulnerableTime <= 0;
+            
+            if (canHit || info.deleteAnyway) CollisionManager::destroyHazard(handle);
+            
+            if (canHit)
+            {
+                health -= int(info.damage * getShipConfig(global_ShipSelect).damageMultiplier);
+                invulnerableTime = 1.0f;
+                
+                if (health <= 0)
+                {
+                    if (deaths++ == 0) firstDeathTime = time;
+                    health = MaxHealth;
+                }
+            }
+        }
+    };
+    
+    // Not a good player, but not a parked one either: the bullets aim at the player and the missiles home on it,
+    // so a ship that never moves takes hits no one playing would. Each tick, the stand-in looks at the hazards
+    // that are or will be within DodgeRange of it horizontally in the next LookAhead seconds (by their mover
+    // velocity, when they have one), and moves up or down away from where they'll be, at up to DodgeSpeed;
+    // with nothing near, it drifts back to the middle
+    constexpr float DodgeSpeed = 240, DodgeRange = 96, LookAhead = 0.5f;
+    
+    static void dodge(Node *player, HazardSelector *selector, const Size &size, float delta)
+    {
+        Vec2 position = player->getPosition();
+        float push = (size.height/2 - position.y) / size.height;
+        
+        for (auto child : selector->getChildren())
+        {
+            // The hazards are in the selector's space, which is scrolled by scrollOffset
+            Vec2 hazard = child->getPosition() - Vec2(selector->scrollOffset, 0), velocity;
+            if (!selector->getMoverVelocity(child, velocity)) velocity = Vec2::ZERO;
+            Vec2 ahead = hazard + velocity * LookAhead;
+            
+            float distance = std::min(fabsf(hazard.x - position.x), fabsf(ahead.x - position.x));
+            if ((hazard.x - position.x) * (ahead.x - position.x) < 0) distance = 0;
+            if (distance > DodgeRange) continue;
+            
+            float dy = position.y - ahead.y;
+            float weight = (1 - distance/DodgeRange) * DodgeRange / (fabsf(dy) + 16);
+            push += dy >= 0 ? weight : -weight;
+        }
+        
+        position.y = clampf(position.y + clampf(push, -1, 1) * DodgeSpeed * delta, 44, size.height-44);
+        player->setPosition(position);
+    }
+    
+    static void runSession(Stats &stats, uint32_t seed, float sessionTime, float timestep)
+    {
+        std::mt19937 engine(seed);
+        global_HazardRandomEngine = &engine;
+        
+        RefPtr<Node> root = Node::create();
+        auto selector = HazardSelector::create();
+        selector->simulated = true;
+        root->addChild(selector);
+        
+        // The root isn't scaled, so the playfield is the same size in world space
+        auto size = selector->getPlayfieldSize();
+        CollisionManager::setPlayfieldHeight(size.height);
+        auto player = Node::create();
+        player->setName("PlayerNode");
+        player->setPosition(48, size.height/2);
+        root->addChild(player);
+        
+        StandInPlayer standIn;
+        float time = 0;
+        auto delegate = [&] (CollisionManager::HazardHandle handle, const CollisionManager::HazardCollisionData &hazard,
+                             const CollisionManager::HazardCollisionData::HazardInfo &info) { standIn.takeDamage(handle, hazard, info, time); };
+        auto projectileDelegate = [] (CollisionManager::HazardHandle, const CollisionManager::HazardCollisionData&,
+                                      const CollisionManager::HazardCollisionData::HazardInfo&) { return false; };
+        
+        const auto &config = getShipConfig(global_ShipSelect);
+        if (config.collisionIsPolygon)
+            CollisionManager::setPlayer(CollisionManager::PlayerCollisionData(player, config.collisionShape.get(), delegate, projectileDelegate));
+        else CollisionManager::setPlayer(CollisionManager::PlayerCollisionData(player, config.collisionOffset * PlayerScale, config.collisionRadius * PlayerScale,
+                                                                              delegate, projectileDelegate));
+        
+        // Entering the root makes the scheduler and the action manager step its nodes, like in a running scene
+        auto scheduler = Director::getInstance()->getScheduler();
+        root->onEnter();
+        
+        int frames = int(sessionTime / timestep);
+        for (int frame = 0; frame < frames; frame++)
+        {
+            dodge(player, selector, size, timestep);
+            selector->worldState.refresh(player, size, selector->speed, timestep);
+            scheduler->update(timestep);
+            selector->tick(timestep);
+            CollisionManager::update();
+            
+            time += timestep;
+            standIn.invulnerableTime -= timestep;
+            
+            int hazards = CollisionManager::getHazardCount();
+            stats.hazardTime += hazards * timestep;
+            stats.peakHazards = std::max(stats.peakHazards, hazards);
+            
+            // Director::mainLoop would do this at the end of each frame
+            PoolManager::getInstance()->getCurrentPool()->clear();
+        }
+        
+        root->onExit();
+        
+        for (int i = 0; i < hazardSpawnerSize; i++) stats.spawnCounts[i] += selector->spawnCounts[i];
+        stats.deaths += standIn.deaths;
+        stats.firstDeathTimes.push_back(standIn.deaths > 0 ? standIn.firstDeathTime : sessionTime);
+        
+        root->removeAllChildren();
+        CollisionManager::clearCollisionData();
+        global_HazardRandomEngine = nullptr;
+    }
+    
+    Stats run(int sessions, float sessionTime, uint32_t seed, float timestep)
+    {
+        CCASSERT(Director::getInstance()->getRunningScene() == nullptr, "The hazard simulator must run before any scene does!");
+        
+        Stats stats;
+        stats.sessions = sessions;
+        stats.sessionTime = sessionTime;
+        stats.spawnCounts.assign(hazardSpawnerSize, 0);
+        
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < sessions; i++) runSession(stats, seed + i, sessionTime, timestep);
+        stats.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        return stats;
+    }
+    
+    void log(const Stats &stats)
+    {
+        double totalTime = double(stats.sessions) * stats.sessionTime;
+        cocos2d::log("Hazard simulation: %d sessions of %gs in %.2fs (%.1f sessions/s)", stats.sessions, stats.sessionTime,
+              stats.wallTime, stats.sessions / stats.wallTime);
+        
+        int totalSpawns = 0;
+        for (int count : stats.spawnCounts) totalSpawns += count;
+        for (int i = 0; i < hazardSpawnerSize; i++)
+            cocos2d::log("  %2d %-40.40s %6d spawns (%5.1f%%)", i, hazardStrings[i].c_str(), stats.spawnCounts[i], 100.0 * stats.spawnCounts[i] / std::max(totalSpawns, 1));
+        
+        cocos2d::log("  Density: %.1f hazards on average, %d at most", stats.hazardTime / totalTime, stats.peakHazards);
+        
+        auto firstDeaths = stats.firstDeathTimes;
+        std::sort(firstDeaths.begin(), firstDeaths.end());
+        int survivors = int(std::count(firstDeaths.begin(), firstDeaths.end(), stats.sessionTime));
+        cocos2d::log("  Survival: %.2f deaths per minute, median first death at %.1fs, %d of %d sessions without dying",
+              stats.deaths / (totalTime / 60), firstDeaths.empty() ? 0.0f : firstDeaths[firstDeaths.size()/2], survivors, stats.sessions);
+    }
+}
@@ -0,0 +1,51 @@
+//
+//  HazardSimulator.h
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#ifndef HazardSimulator_h
+#define HazardSimulator_h
+
+#include <vector>
+#include <cstdint>
+
+// What AppDelegate runs when HAZARD_SIMULATOR is set; each can be overridden from the build flags
+#ifndef HAZARD_SIMULATOR_SESSIONS
+#define HAZARD_SIMULATOR_SESSIONS 100
+#endif
+#ifndef HAZARD_SIMULATOR_SESSION_TIME
+#define HAZARD_SIMULATOR_SESSION_TIME 300
+#endif
+#ifndef HAZARD_SIMULATOR_SEED
+#define HAZARD_SIMULATOR_SEED 1
+#endif
+
+// Fast-forwards whole game sessions for balancing hazardSpawners: a real HazardSelector, its spawners'
+// actions and schedules and the CollisionManager are stepped with a fixed timestep, and nothing is drawn.
+// The player is a stand-in that starts where the game spawns it, dodges up and down with a simple policy
+// (see dodge) and takes every hit like PlayerNode does; when its health runs out, that counts as a death and
+// it keeps going with full health.
+// Everything runs on the main thread (the scene graph isn't thread-safe), before any scene is running
+namespace HazardSimulator
+{
+    struct Stats
+    {
+        int sessions = 0;
+        float sessionTime = 0;
+        std::vector<int> spawnCounts;       // per entry of hazardSpawners, over all sessions
+        double hazardTime = 0;              // live collision hazards integrated over time, for the mean density
+        int peakHazards = 0;
+        int deaths = 0;
+        std::vector<float> firstDeathTimes; // per session; the whole session time if the player never died
+        double wallTime = 0;                // seconds spent simulating
+    };
+    
+    // Session i is seeded with seed+i, so runs with the same arguments give the same stats
+    Stats run(int sessions, float sessionTime, uint32_t seed, float timestep = 1.0f/60);
+    void log(const Stats &stats);
+}
+
+#endif /* HazardSimulator_h */
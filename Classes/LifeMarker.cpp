@@ -49,7 +49,7 @@ bool LifeMarkers::init(const Size &screenSize)
     
     lifeText->setPosition(lifeIndicatorSprite->getPosition() + Vec2(22 + lifeText->getContentSize().width/2, 1));
     
-    listener = _eventDispatcher->addCustomEventListener("LifeUpdate", CC_CALLBACK_1(LifeMarkers::lifeUpdate, this));
+    listener = GameEvents::subscribe<GameEvents::LifeUpdate>(CC_CALLBACK_1(LifeMarkers::lifeUpdate, this));
     
     targetLives = currentLives = 100;
     
@@ -58,7 +58,7 @@ bool LifeMarkers::init(const Size &screenSize)
 
 LifeMarkers::~LifeMarkers()
 {
-    _eventDispatcher->removeEventListener(listener);
+    GameEvents::unsubscribe<GameEvents::LifeUpdate>(listener);
 }
 
 void LifeMarkers::onEnterTransitionDidFinish()
@@ -79,9 +79,9 @@ void LifeMarkers::onExitTransitionDidStart()
     recursivePause(this);
 }
 
-void LifeMarkers::lifeUpdate(EventCustom *event)
+void LifeMarkers::lifeUpdate(const GameEvents::LifeUpdate &event)
 {
-    targetLives = std::abs(*static_cast<int*>(event->getUserData()));
+    targetLives = std::abs(event.health);
 }
 
 void LifeMarkers::update(float delta)
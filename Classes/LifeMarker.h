@@ -10,16 +10,17 @@
 #define __SpaceExplorer__LifeMarker__
 
 #include "cocos2d.h"
+#include "GameEvents.h"
 
 class LifeMarkers : public cocos2d::Node
 {
     cocos2d::Sprite *lifeIndicatorSprite;
     cocos2d::Label *lifeText;
-    cocos2d::EventListenerCustom *listener;
+    GameEvents::ListenerId listener;
     
     float targetLives, currentLives;
     
-    void lifeUpdate(cocos2d::EventCustom *event);
+    void lifeUpdate(const GameEvents::LifeUpdate &event);
     bool init(const cocos2d::Size &screenSize);
     
 public:
@@ -30,6 +31,8 @@ public:
     virtual void update(float delta) override;
     virtual void draw(cocos2d::Renderer *renderer, const cocos2d::Mat4& transform, uint32_t flags) override;
     
+    inline void reset() { targetLives = currentLives = 100; }
+    
     virtual ~LifeMarkers();
     
     static LifeMarkers *create(const cocos2d::Size &screenSize);
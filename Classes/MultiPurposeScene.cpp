@@ -174,7 +174,14 @@ void MultiPurposeLayer::createLayout1Title()
     BlurNode *blur = BlurNode::create(_director->getWinSize(), hazard);
     addChild(blur, 0);
     
-    hazard->artificiallyAdvance(3600);
+    // The background used to be warmed up by simulating a minute of hazards, but only what spawned in the
+    // last seconds is still on screen: skip the difficulty clock ahead, and simulate just long enough for
+    // the slowest hazards (the cube walls) to cross the playfield
+    constexpr float WarmupTime = 57.6f, SlowestHazardSpeed = 112.5f, FrameTime = 0.016f;
+    float crossingTime = (hazard->getPlayfieldSize().width + 48) / (SlowestHazardSpeed * 0.5f);
+    hazard->advanceClock(std::max(WarmupTime - crossingTime, 0.0f));
+    hazard->spawnTime = 0;
+    hazard->artificiallyAdvance(int(std::min(crossingTime, WarmupTime) / FrameTime));
     
     auto titleLabel = Sprite::createWithSpriteFrameName("GameName.png");
     titleLabel->setPosition(size.width/2, size.height*.84);
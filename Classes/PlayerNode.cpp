@@ -15,6 +15,8 @@
 #include "GameScene.h"
 #include "SoundManager.h"
 #include "AchievementManager.h"
+#include "GameEvents.h"
+#include "FlipbookSprite.h"
 
 unsigned long global_ShipSelect = 0;
 
@@ -30,7 +32,9 @@ constexpr int FRONT_SPRITE = 9;
 constexpr int BACK_SPRITE = 10;
 
 constexpr float AnimationRate = 60.0f;
-constexpr float PlayerScale = 0.78125f;
+
+// The tilt speed is per step at this rate, which is what it was tuned for
+constexpr float TiltReferenceRate = 60.0f;
 
 using namespace cocos2d;
 
@@ -38,10 +42,10 @@ void PlayerNode::updateCollisionData()
 {
     const auto& config = getShipConfig(global_ShipSelect);
     if (config.collisionIsPolygon)
-        CollisionManager::setPlayer(CollisionManager::PlayerCollisionData(this, &config.collisionList[0], (int)config.collisionList.size(), PlayerScale,
-                                                                          CC_CALLBACK_1(PlayerNode::takeDamage, this), CC_CALLBACK_1(PlayerNode::projectileDamage, this)));
+        CollisionManager::setPlayer(CollisionManager::PlayerCollisionData(this, config.collisionShape.get(),
+                                                                          CC_CALLBACK_3(PlayerNode::takeDamage, this), CC_CALLBACK_3(PlayerNode::projectileDamage, this)));
     else CollisionManager::setPlayer(CollisionManager::PlayerCollisionData(this, config.collisionOffset * PlayerScale, config.collisionRadius * PlayerScale,
-                                                                              CC_CALLBACK_1(PlayerNode::takeDamage, this), CC_CALLBACK_1(PlayerNode::projectileDamage, this)));
+                                                                              CC_CALLBACK_3(PlayerNode::takeDamage, this), CC_CALLBACK_3(PlayerNode::projectileDamage, this)));
 }
 
 bool PlayerNode::init()
@@ -49,8 +53,6 @@ bool PlayerNode::init()
     if (!Node::init())
         return false;
     
-    scheduleUpdate();
-    
     fixedUpdateInterval = 0;
     shieldIcon = nullptr;
     motionProcessor = nullptr;
@@ -106,6 +108,19 @@ bool PlayerNode::init()
     return true;
 }
 
+// Every ship shares the same jet and shield animations, resolved on first use
+static const FlipbookClip &getJetFireClip()
+{
+    static FlipbookClip clip("JetFire", 30);
+    return clip;
+}
+
+static const FlipbookClip &getShieldClip()
+{
+    static FlipbookClip clip("ShieldAnimation", 24);
+    return clip;
+}
+
 PlayerNode::~PlayerNode()
 {
     GLProgramState::getOrCreateWithGLProgramName("PlayerShapeProgram")->setUniformCallback("tintAmount", nullptr);
@@ -115,7 +130,7 @@ void PlayerNode::createJetFlames()
 {
     for (Vec2 pos : getShipConfig(global_ShipSelect).jetPositions)
     {
-        auto jet = Sprite::createWithSpriteFrameName("JetFire1.png");
+        auto jet = FlipbookSprite::create(getJetFireClip());
         jet->setPosition(Vec2(pos.x - 32, pos.y - 32) * PlayerScale);
         jet->setScale(getShipConfig(global_ShipSelect).jetScale * PlayerScale);
         addChild(jet, -1);
@@ -130,40 +145,31 @@ void PlayerNode::createJetFlames()
     currentJetAnimation = 0;
 }
 
-void PlayerNode::takeDamage(const CollisionManager::HazardCollisionData &hazard)
+void PlayerNode::takeDamage(CollisionManager::HazardHandle handle, const CollisionManager::HazardCollisionData &hazard, const CollisionManager::HazardCollisionData::HazardInfo &info)
 {
     bool canHit = !damage && !invincible;
     
-    if (canHit || hazard.info.deleteAnyway)
-    {
-        hazard.positionNode->removeFromParentAndCleanup(true);
-        if (hazard.otherNode) hazard.otherNode->removeFromParentAndCleanup(true);
-        if (hazard.info.companionNode[0]) hazard.info.companionNode[0]->removeFromParent();
-        if (hazard.info.companionNode[1]) hazard.info.companionNode[1]->removeFromParent();
-    }
+    if (canHit || info.deleteAnyway) CollisionManager::destroyHazard(handle);
     
     if (canHit)
     {
         SoundManager::play("common/Damage.wav");
         
         damage = true;
-        health = std::max(health - int(hazard.info.damage * getShipConfig(global_ShipSelect).damageMultiplier), 0);
+        health = std::max(health - int(info.damage * getShipConfig(global_ShipSelect).damageMultiplier), 0);
         
-        _eventDispatcher->dispatchCustomEvent("LifeUpdate", &health);
+        GameEvents::post(GameEvents::LifeUpdate{health});
         runAction(Sequence::create(DelayTime::create(1.0), CallFunc::create([this] { damage = false; }), nullptr));
     }
 }
 
-void PlayerNode::takeShieldDamage(const CollisionManager::HazardCollisionData &hazard)
+void PlayerNode::takeShieldDamage(CollisionManager::HazardHandle handle, const CollisionManager::HazardCollisionData &hazard, const CollisionManager::HazardCollisionData::HazardInfo &info)
 {
     if (!invincible)
     {
-        hazard.positionNode->removeFromParentAndCleanup(true);
-        if (hazard.otherNode) hazard.otherNode->removeFromParentAndCleanup(true);
-        if (hazard.info.companionNode[0]) hazard.info.companionNode[0]->removeFromParent();
-        if (hazard.info.companionNode[1]) hazard.info.companionNode[1]->removeFromParent();
+        CollisionManager::destroyHazard(handle);
         
-        if (hazard.info.penetratesShield)
+        if (info.penetratesShield)
         {
             damage = true;
             shieldIcon->collapse(true);
@@ -181,20 +187,14 @@ void PlayerNode::takeShieldDamage(const CollisionManager::HazardCollisionData &h
     }
 }
 
-bool PlayerNode::projectileDamage(const CollisionManager::HazardCollisionData &hazard)
+bool PlayerNode::projectileDamage(CollisionManager::HazardHandle handle, const CollisionManager::HazardCollisionData &hazard, const CollisionManager::HazardCollisionData::HazardInfo &info)
 {
-    if (hazard.info.projectileScore != -1)
+    if (info.projectileScore != -1)
     {
-        int val = hazard.info.projectileScore;
-        _eventDispatcher->dispatchCustomEvent("ScoreUpdate", &val);
+        GameEvents::post(GameEvents::ScoreUpdate{info.projectileScore});
 		AchievementManager::increaseStat("HazardHit", 1);
         
-        for (Node *hz : { hazard.positionNode, hazard.otherNode, hazard.info.companionNode[0].get(), hazard.info.companionNode[1].get() })
-        {
-            if (!hz) continue;
-            hz->stopAllActions();
-            hz->removeFromParent();
-        }
+        CollisionManager::destroyHazard(handle);
         
         SoundManager::play("common/FireballSplit.wav");
         
@@ -230,8 +230,7 @@ void PlayerNode::onEnter()
         setPosition(48, size.height/2);
         alreadyPositioned = true;
         
-        int opHealth = -health;
-        _eventDispatcher->dispatchCustomEvent("LifeUpdate", &opHealth);
+        GameEvents::post(GameEvents::LifeUpdate{-health});
     }
 }
 
@@ -264,8 +263,7 @@ void PlayerNode::increaseHealth(int amount)
     
     health = std::min(health + amount, MaxHealth);
     
-    int opHealth = -health;
-    _eventDispatcher->dispatchCustomEvent("LifeUpdate", &opHealth);
+    GameEvents::post(GameEvents::LifeUpdate{-health});
 }
 
 void PlayerNode::update(float delta)
@@ -276,13 +274,13 @@ void PlayerNode::update(float delta)
     for (; fixedAnimationInterval > 1; fixedAnimationInterval -= 1)
     {
         currentJetAnimation = (currentJetAnimation + 1) % 60;
-        for (auto jet : jetFlames) jet->setSpriteFrame("JetFire" + ulongToString(currentJetAnimation/2+1) + ".png");
+        for (auto jet : jetFlames) jet->setFrameIndex(currentJetAnimation/2);
         
         currentShieldAnimation = (currentShieldAnimation + 1) % 24;
-        auto sprite = getChildByTag<Sprite*>(SHIELD_FRONT);
-        if (sprite) sprite->setSpriteFrame("ShieldAnimation" + ulongToString(currentShieldAnimation+1) + ".png");
-        sprite = getChildByTag<Sprite*>(SHIELD_BACK);
-        if (sprite) sprite->setSpriteFrame("ShieldAnimation" + ulongToString(24-currentShieldAnimation) + ".png");
+        auto sprite = getChildByTag<FlipbookSprite*>(SHIELD_FRONT);
+        if (sprite) sprite->setFrameIndex(currentShieldAnimation);
+        sprite = getChildByTag<FlipbookSprite*>(SHIELD_BACK);
+        if (sprite) sprite->setFrameIndex(23-currentShieldAnimation);
     }
     
     if (withShooter)
@@ -306,7 +304,7 @@ void PlayerNode::update(float delta)
     
     if (!touching && motionProcessor)
     {
-        auto velocity = motionProcessor->getDirectionVector() * UserDefault::getInstance()->getIntegerForKey("TiltSensitivity");
+        auto velocity = motionProcessor->getDirectionVector() * UserDefault::getInstance()->getIntegerForKey("TiltSensitivity") * (delta * TiltReferenceRate);
         auto pos = getPosition() + velocity;
         
         auto size = static_cast<GameScene*>(getParent()->getParent())->getPlayfieldSize();
@@ -326,8 +324,8 @@ void PlayerNode::addShield()
     auto blink = EaseSineInOut::create(FadeTo::create(0.4, 150));
     auto blink2 = EaseSineInOut::create(FadeTo::create(0.4, 255));
     
-    auto animationFront = Sprite::create();
-    auto animationBack = Sprite::create();
+    Sprite *animationFront = FlipbookSprite::create(getShieldClip(), 0);
+    Sprite *animationBack = FlipbookSprite::create(getShieldClip(), 23);
     
     glowingBorder->runAction(RepeatForever::create(Sequence::createWithTwoActions(blink, blink2)));
     
@@ -344,8 +342,8 @@ void PlayerNode::addShield()
     addChild(animationFront, 2, SHIELD_FRONT);
     addChild(glowingBorder, -5, SHIELD_BORDER);
     
-    CollisionManager::setPlayer(CollisionManager::PlayerCollisionData(this, Vec2::ZERO, 40, CC_CALLBACK_1(PlayerNode::takeShieldDamage, this),
-                                                                      CC_CALLBACK_1(PlayerNode::projectileDamage, this)));
+    CollisionManager::setPlayer(CollisionManager::PlayerCollisionData(this, Vec2::ZERO, 40, CC_CALLBACK_3(PlayerNode::takeShieldDamage, this),
+                                                                      CC_CALLBACK_3(PlayerNode::projectileDamage, this)));
     
     onShield = true;
 }
@@ -441,3 +439,44 @@ void PlayerNode::turnInvincibility()
     invincible = true;
     runAction(Sequence::create(DelayTime::create(8.0), CallFunc::create([this] { invincible = false; }), nullptr));
 }
+
+void PlayerNode::reset()
+{
+    stopAllActions();
+    
+    for (int tag : { SHIELD_BORDER, SHIELD_BACK, SHIELD_FRONT, SHOOT_DRONE })
+        removeChildByTag(tag);
+    
+    damage = touching = alreadyPositioned = onShield = withShooter = invincible = false;
+    health = MaxHealth;
+    shieldIcon = nullptr;
+    
+    damageTimer = 2*BlinkTime;
+    tintAmount = 0;
+    setRotation(0);
+    
+    updateCollisionData();
+}
+
+void PlayerNode::saveSnapshot(WorldSnapshot::Writer &writer) const
+{
+    writer.write(getPosition());
+    writer.write(getRotation());
+    writer.write(int32_t(health));
+}
+
+bool PlayerNode::restoreSnapshot(WorldSnapshot::Reader &reader)
+{
+    auto position = reader.readVec2();
+    auto rotation = reader.read<float>();
+    int health = reader.read<int32_t>();
+    if (!reader.isValid() || health <= 0 || health > MaxHealth) return false;
+    
+    setPosition(position);
+    setRotation(rotation);
+    this->health = health;
+    alreadyPositioned = true;
+    
+    GameEvents::post(GameEvents::LifeUpdate{-health});
+    return true;
+}
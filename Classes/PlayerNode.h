@@ -12,6 +12,8 @@
 #include "cocos2d.h"
 #include "MotionProcessor.h"
 #include "CollisionManager.h"
+#include "WorldSnapshot.h"
+#include "FlipbookSprite.h"
 
 constexpr int MaxHealth = 100;
 
@@ -25,7 +27,7 @@ class PlayerNode : public cocos2d::Node
     MotionProcessor *motionProcessor;
     PowerupIcon *shieldIcon;
     
-    cocos2d::Vector<cocos2d::Sprite*> jetFlames;
+    cocos2d::Vector<FlipbookSprite*> jetFlames;
     float fixedAnimationInterval;
     int currentJetAnimation;
     int currentShieldAnimation;
@@ -36,18 +38,17 @@ class PlayerNode : public cocos2d::Node
     
     void updateCollisionData();
     
-    void takeDamage(const CollisionManager::HazardCollisionData &hazard);
-    void takeShieldDamage(const CollisionManager::HazardCollisionData &hazard);
+    void takeDamage(CollisionManager::HazardHandle handle, const CollisionManager::HazardCollisionData &hazard, const CollisionManager::HazardCollisionData::HazardInfo &info);
+    void takeShieldDamage(CollisionManager::HazardHandle handle, const CollisionManager::HazardCollisionData &hazard, const CollisionManager::HazardCollisionData::HazardInfo &info);
     
     void shootProjectile();
-    bool projectileDamage(const CollisionManager::HazardCollisionData &hazard);
+    bool projectileDamage(CollisionManager::HazardHandle handle, const CollisionManager::HazardCollisionData &hazard, const CollisionManager::HazardCollisionData::HazardInfo &info);
     
     bool onTouchBegan(cocos2d::Touch* touch, cocos2d::Event* event);
     void onTouchEnded(cocos2d::Touch* touch, cocos2d::Event* event);
     
     void createJetFlames();
     
-    virtual void update(float delta) override;
     virtual void onEnterTransitionDidFinish() override;
     virtual void onExitTransitionDidStart() override;
     virtual void onEnter() override;
@@ -56,6 +57,9 @@ public:
     bool init();
     virtual ~PlayerNode();
     
+    // Not scheduled: the scene steps it on the game's fixed ticks (see GameScene::update)
+    virtual void update(float delta) override;
+    
     void increaseHealth(int health);
     void addShield();
     void changeShieldIcon(PowerupIcon *icon);
@@ -65,6 +69,13 @@ public:
     
     void turnInvincibility();
     
+    // Back to a new ship, with full health and no powerups; it's positioned again once it's added back
+    void reset();
+    
+    // Where the ship is and its health; the powerups it has on are left out
+    void saveSnapshot(WorldSnapshot::Writer &writer) const;
+    bool restoreSnapshot(WorldSnapshot::Reader &reader);
+    
     CREATE_FUNC(PlayerNode);
 };
 
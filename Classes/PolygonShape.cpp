@@ -0,0 +1,259 @@
+//
+//  PolygonShape.cpp
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#include "PolygonShape.h"
+#include <unordered_map>
+#include <cstring>
+
+using namespace cocos2d;
+
+// Never destroyed, since shapes held by other static objects may be released after it would be
+static std::unordered_multimap<uint32_t, PolygonShape*> &getSharedShapes()
+{
+    static auto shapes = new std::unordered_multimap<uint32_t, PolygonShape*>();
+    return *shapes;
+}
+
+// FNV-1a over the bits of the scaled points
+static uint32_t hashPoints(const Vec2 *points, int count, float scale)
+{
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < count; i++)
+    {
+        float coords[2] = { points[i].x * scale, points[i].y * scale };
+        unsigned char bytes[sizeof(coords)];
+        memcpy(bytes, coords, sizeof(coords));
+        for (unsigned char byte : bytes) hash = (hash ^ byte) * 16777619u;
+    }
+    return hash;
+}
+
+PolygonShape *PolygonShape::create(const Vec2 *points, int count, float scale)
+{
+    PolygonShape *pRet = new(std::nothrow) PolygonShape();
+    if (pRet && pRet->init(points, count, scale))
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+    else
+    {
+        delete pRet;
+        pRet = nullptr;
+        return nullptr;
+    }
+}
+
+PolygonShape *PolygonShape::getOrCreate(const Vec2 *points, int count, float scale)
+{
+    uint32_t hash = hashPoints(points, count, scale);
+    
+    auto range = getSharedShapes().equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const auto &vertices = it->second->vertices;
+        if ((int)vertices.size() != count) continue;
+        
+        bool equal = true;
+        for (int i = 0; i < count && equal; i++) equal = vertices[i] == points[i] * scale;
+        if (equal) return it->second;
+    }
+    
+    auto shape = create(points, count, scale);
+    if (shape)
+    {
+        shape->hash = hash;
+        shape->interned = true;
+        getSharedShapes().emplace(hash, shape);
+    }
+    return shape;
+}
+
+PolygonShape::~PolygonShape()
+{
+    if (!interned) return;
+    
+    auto &shapes = getSharedShapes();
+    auto range = shapes.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+        if (it->second == this)
+        {
+            shapes.erase(it);
+            break;
+        }
+}
+
+static Vec2 boundingCenter(const Vec2 *points, const int *indices, int count)
+{
+    Vec2 min = points[indices[0]], max = points[indices[0]];
+    for (int i = 1; i < count; i++)
+    {
+        const Vec2 &point = points[indices[i]];
+        min.x = std::min(min.x, point.x); min.y = std::min(min.y, point.y);
+        max.x = std::max(max.x, point.x); max.y = std::max(max.y, point.y);
+    }
+    return (min + max) / 2;
+}
+
+static float boundingRadius(const Vec2 *points, const int *indices, int count, const Vec2 &center)
+{
+    float radius = 0;
+    for (int i = 0; i < count; i++) radius = std::max(radius, points[indices[i]].distanceSquared(center));
+    return sqrtf(radius);
+}
+
+bool PolygonShape::init(const Vec2 *points, int count, float scale)
+{
+    // Sanity check
+    if (count < 3)
+    {
+        CCLOG("Point list has less than 3 elements!");
+        return false;
+    }
+    
+    vertices.resize(count);
+    for (int i = 0; i < count; i++) vertices[i] = points[i] * scale;
+    
+    decompose();
+    
+    std::vector<int> all(count);
+    for (int i = 0; i < count; i++) all[i] = i;
+    center = boundingCenter(vertices.data(), all.data(), count);
+    radius = boundingRadius(vertices.data(), all.data(), count, center);
+    
+    return true;
+}
+
+inline static float turn(const Vec2 &a, const Vec2 &b, const Vec2 &c)
+{
+    return (b - a).cross(c - b);
+}
+
+static bool isConvex(const std::vector<Vec2> &vertices, const std::vector<int> &indices)
+{
+    int count = (int)indices.size();
+    for (int i = 0; i < count; i++)
+        if (turn(vertices[indices[i]], vertices[indices[(i+1)%count]], vertices[indices[(i+2)%count]]) < 0)
+            return false;
+    return true;
+}
+
+inline static bool insideTriangle(const Vec2 &point, const Vec2 &a, const Vec2 &b, const Vec2 &c)
+{
+    return (b - a).cross(point - a) >= 0 && (c - b).cross(point - b) >= 0 && (a - c).cross(point - c) >= 0;
+}
+
+// Ear clipping, followed by Hertel-Mehlhorn: diagonals are removed as long as the
+// two pieces they separate form a convex piece together
+void PolygonShape::decompose()
+{
+    int count = (int)vertices.size();
+    
+    // Work on a counter-clockwise ordering
+    float area = 0;
+    for (int i = 0; i < count; i++) area += vertices[i].cross(vertices[(i+1)%count]);
+    
+    std::vector<int> polygon(count);
+    for (int i = 0; i < count; i++) polygon[i] = area >= 0 ? i : count-1-i;
+    
+    if (isConvex(vertices, polygon))
+    {
+        addPiece(polygon);
+        return;
+    }
+    
+    std::vector<std::vector<int>> parts;
+    while (polygon.size() > 3)
+    {
+        int size = (int)polygon.size(), ear = -1;
+        for (int i = 0; i < size && ear < 0; i++)
+        {
+            int prev = polygon[(i+size-1)%size], cur = polygon[i], next = polygon[(i+1)%size];
+            if (turn(vertices[prev], vertices[cur], vertices[next]) <= 0) continue;
+            
+            bool empty = true;
+            for (int j = 0; j < size && empty; j++)
+            {
+                int other = polygon[j];
+                if (other == prev || other == cur || other == next) continue;
+                if (insideTriangle(vertices[other], vertices[prev], vertices[cur], vertices[next])) empty = false;
+            }
+            if (empty) ear = i;
+        }
+        
+        // Degenerate or self-intersecting polygons may have no ear left. A collinear or reflex vertex is dropped
+        // then, without a piece, since its triangle isn't convex; SAT would test it with inward normals
+        if (ear < 0)
+        {
+            int dropped = 0;
+            for (int i = 0; i < size; i++)
+                if (turn(vertices[polygon[(i+size-1)%size]], vertices[polygon[i]], vertices[polygon[(i+1)%size]]) <= 0)
+                {
+                    dropped = i;
+                    break;
+                }
+            
+            CCASSERT(turn(vertices[polygon[(dropped+size-1)%size]], vertices[polygon[dropped]], vertices[polygon[(dropped+1)%size]]) <= 0,
+                     "PolygonShape: the polygon must be simple!");
+            polygon.erase(polygon.begin() + dropped);
+            continue;
+        }
+        
+        parts.push_back({ polygon[(ear+size-1)%size], polygon[ear], polygon[(ear+1)%size] });
+        polygon.erase(polygon.begin() + ear);
+    }
+    if (turn(vertices[polygon[0]], vertices[polygon[1]], vertices[polygon[2]]) > 0) parts.push_back(polygon);
+    
+    // Merge the pieces that share an edge (u, v) in one and (v, u) in the other
+    for (bool merged = true; merged;)
+    {
+        merged = false;
+        for (size_t p = 0; p < parts.size() && !merged; p++)
+            for (size_t q = p+1; q < parts.size() && !merged; q++)
+            {
+                const auto &first = parts[p], &second = parts[q];
+                int firstSize = (int)first.size(), secondSize = (int)second.size();
+                
+                for (int i = 0; i < firstSize && !merged; i++)
+                    for (int j = 0; j < secondSize && !merged; j++)
+                    {
+                        if (first[i] != second[(j+1)%secondSize] || first[(i+1)%firstSize] != second[j]) continue;
+                        
+                        std::vector<int> candidate;
+                        for (int k = 0; k < firstSize; k++) candidate.push_back(first[(i+1+k)%firstSize]);
+                        for (int k = 2; k < secondSize; k++) candidate.push_back(second[(j+k)%secondSize]);
+                        
+                        if (isConvex(vertices, candidate))
+                        {
+                            parts[p] = std::move(candidate);
+                            parts.erase(parts.begin() + q);
+                            merged = true;
+                        }
+                    }
+            }
+    }
+    
+    for (const auto &part : parts) addPiece(part);
+}
+
+void PolygonShape::addPiece(const std::vector<int> &indices)
+{
+    ConvexPiece piece;
+    piece.indexStart = (int)pieceIndices.size();
+    piece.indexCount = (int)indices.size();
+    piece.center = boundingCenter(vertices.data(), indices.data(), piece.indexCount);
+    piece.radius = boundingRadius(vertices.data(), indices.data(), piece.indexCount, piece.center);
+    pieces.push_back(piece);
+    
+    for (int i = 0; i < piece.indexCount; i++)
+    {
+        auto edge = vertices[indices[(i+1)%piece.indexCount]] - vertices[indices[i]];
+        pieceIndices.push_back(indices[i]);
+        pieceNormals.push_back(Vec2(edge.y, -edge.x));
+    }
+}
@@ -0,0 +1,67 @@
+//
+//  PolygonShape.h
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#ifndef PolygonShape_h
+#define PolygonShape_h
+
+#include "cocos2d.h"
+#include <vector>
+#include <cstdint>
+
+// A collision polygon with everything the narrowphase needs precomputed once, when it's created:
+// a decomposition into convex pieces (counter-clockwise), their outward edge normals and the
+// bounding circles of each piece and of the whole polygon. Shapes are immutable, so the ones
+// with the same (scaled) points are shared through getOrCreate
+class PolygonShape : public cocos2d::Ref
+{
+public:
+    struct ConvexPiece
+    {
+        int indexStart, indexCount;     // into getPieceIndices(), which index into getVertices()
+        cocos2d::Vec2 center;
+        float radius;
+    };
+
+private:
+    std::vector<cocos2d::Vec2> vertices;
+    std::vector<int> pieceIndices;
+    std::vector<cocos2d::Vec2> pieceNormals;
+    std::vector<ConvexPiece> pieces;
+    cocos2d::Vec2 center;
+    float radius;
+    uint32_t hash;
+    bool interned = false;
+    
+    bool init(const cocos2d::Vec2 *points, int count, float scale);
+    void decompose();
+    void addPiece(const std::vector<int> &indices);
+
+public:
+    // The points are copied (and multiplied by scale), so they don't need to outlive the shape
+    static PolygonShape *create(const cocos2d::Vec2 *points, int count, float scale = 1);
+    
+    // Returns the live shape with exactly these points (after scaling) if there's one, or creates and
+    // registers a new one. The registry doesn't retain its shapes; they leave it when they're destroyed
+    static PolygonShape *getOrCreate(const cocos2d::Vec2 *points, int count, float scale = 1);
+    
+    virtual ~PolygonShape();
+    
+    inline const std::vector<cocos2d::Vec2> &getVertices() const { return vertices; }
+    inline int getVertexCount() const { return (int)vertices.size(); }
+    
+    inline const std::vector<ConvexPiece> &getPieces() const { return pieces; }
+    inline const std::vector<int> &getPieceIndices() const { return pieceIndices; }
+    
+    // Parallel to getPieceIndices(): the normal of the edge that starts at the same position
+    inline const std::vector<cocos2d::Vec2> &getPieceNormals() const { return pieceNormals; }
+    
+    inline cocos2d::Vec2 getCenter() const { return center; }
+    inline float getBoundingRadius() const { return radius; }
+};
+
+#endif /* PolygonShape_h */
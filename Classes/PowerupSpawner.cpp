@@ -111,12 +111,10 @@ bool PowerupSpawner::init()
     if (!Node::init())
         return false;
     
-    spawnNumber = 0;
-    auto action = CallFunc::create(CC_CALLBACK_0(PowerupSpawner::spawnPowerup, this));
-    runAction(Sequence::createWithTwoActions(DelayTime::create(16), action));
     icons.reserve(3);
+    reset();
     
-    listener = _eventDispatcher->addCustomEventListener("LifeUpdate", CC_CALLBACK_1(PowerupSpawner::detectDeath, this));
+    listener = GameEvents::subscribe<GameEvents::LifeUpdate>(CC_CALLBACK_1(PowerupSpawner::detectDeath, this));
     
     scheduleUpdate();
     
@@ -125,7 +123,7 @@ bool PowerupSpawner::init()
 
 PowerupSpawner::~PowerupSpawner()
 {
-    _eventDispatcher->removeEventListener(listener);
+    GameEvents::unsubscribe<GameEvents::LifeUpdate>(listener);
 }
 
 void PowerupSpawner::onEnterTransitionDidFinish()
@@ -149,14 +147,38 @@ void PowerupSpawner::onEnter()
     for (Node *node : getChildren()) node->pause();
 }
 
+// The spawner's countdown to the next powerup, and each powerup's flight, so they can be read back for a snapshot
+constexpr int SpawnActionTag = 0x7400, FlightActionTag = 0x7401;
+
 void PowerupSpawner::spawnPowerup()
+{
+    const Size &size = static_cast<GameScene*>(getParent()->getParent())->getPlayfieldSize();
+    int value = random(0, 20);
+    addPowerup(value, Vec2(size.width + 20, random<int>(40, size.height-40)));
+    scheduleSpawn(16 + 0.75*(++spawnNumber));
+    
+    if (!UserDefault::getInstance()->getBoolForKey("PowerupPresented"))
+    {
+        GameEvents::post(GameEvents::TutorialMessage{"Collect powerups for some help"});
+        
+        UserDefault::getInstance()->setBoolForKey("PowerupPresented", true);
+    }
+}
+
+void PowerupSpawner::scheduleSpawn(float delay)
+{
+    auto action = Sequence::createWithTwoActions(DelayTime::create(delay), CallFunc::create(CC_CALLBACK_0(PowerupSpawner::spawnPowerup, this)));
+    action->setTag(SpawnActionTag);
+    runAction(action);
+}
+
+void PowerupSpawner::addPowerup(int value, Vec2 position)
 {
     constexpr float MoveSpeed = 120;
     
     std::string spriteName;
     std::function<void(PlayerNode*, Sprite*)> func;
     
-    int value = random(0, 20);
     switch (value)
     {
         case 0: case 1: case 2: case 3: case 4: case 5: case 6:
@@ -184,16 +206,10 @@ void PowerupSpawner::spawnPowerup()
             spriteName = "PowerupDoubleScore.png";
             func = [this] (PlayerNode *player, Sprite *sprite)
             {
-                bool value = true;
-                auto eventDispatcher = _eventDispatcher;
-                _eventDispatcher->dispatchCustomEvent("TriggerDoubleScore", &value);
+                GameEvents::post(GameEvents::DoubleScore{true});
                 
                 sprite->stopAllActions();
-                addIconToQueue(PowerupIcon::create(sprite, 18, [eventDispatcher]
-                {
-                    bool value = false;
-                    eventDispatcher->dispatchCustomEvent("TriggerDoubleScore", &value);
-                }), "DoubleScoreIcon");
+                addIconToQueue(PowerupIcon::create(sprite, 18, [] { GameEvents::post(GameEvents::DoubleScore{false}); }), "DoubleScoreIcon");
             };
             break;
         case 16: case 17: case 18: case 19:
@@ -210,7 +226,7 @@ void PowerupSpawner::spawnPowerup()
             spriteName = "PowerupAdvance.png";
             func = [this] (PlayerNode *player, Sprite *sprite)
             {
-                _eventDispatcher->dispatchCustomEvent("TriggerAdvancePowerup");
+                GameEvents::post(GameEvents::AdvancePowerup());
                 sprite->stopAllActions();
                 player->turnInvincibility();
                 
@@ -220,34 +236,25 @@ void PowerupSpawner::spawnPowerup()
             //CCASSERT(false, "PowerupSpawner switch should not branch to default! Adjust your random config!");
     }
     
-    const Size &size = static_cast<GameScene*>(getParent()->getParent())->getPlayfieldSize();
-    
     auto sprite = Sprite::create(spriteName);
-    sprite->setPosition(size.width + 20, random<int>(40, size.height-40));
+    sprite->setPosition(position);
     sprite->setAnchorPoint(Vec2(0.5, 0.5));
+    sprite->setTag(value);
     
-    float distance = size.width + 40;
-    sprite->runAction(Sequence::createWithTwoActions(MoveBy::create(distance/MoveSpeed, Vec2(-distance, 0)), RemoveSelf::create()));
+    // Until it's past the left edge
+    float distance = position.x + 20;
+    auto flight = Sequence::createWithTwoActions(MoveBy::create(distance/MoveSpeed, Vec2(-distance, 0)), RemoveSelf::create());
+    flight->setTag(FlightActionTag);
+    sprite->runAction(flight);
     
     addChild(sprite);
     
-    CollisionManager::addPowerup(CollisionManager::PowerupCollisionData(sprite, Vec2::ZERO, 16, [func, sprite] (const CollisionManager::PlayerCollisionData &data)
+    CollisionManager::addPowerup(CollisionManager::PowerupCollisionData(sprite, Vec2::ZERO, 16), [func, sprite] (const CollisionManager::PlayerCollisionData &data)
     {
 		AchievementManager::increaseStat("PowerupCollected", 1);
         SoundManager::play("common/PowerupTaken.wav");
         func(static_cast<PlayerNode*>(data.positionNode), sprite);
-    }));
-    
-    auto action = CallFunc::create(CC_CALLBACK_0(PowerupSpawner::spawnPowerup, this));
-    runAction(Sequence::createWithTwoActions(DelayTime::create(16 + 0.75*(++spawnNumber)), action));
-    
-    if (!UserDefault::getInstance()->getBoolForKey("PowerupPresented"))
-    {
-        std::string str = "Collect powerups for some help";
-        _eventDispatcher->dispatchCustomEvent("TutorialMessage", &str);
-        
-        UserDefault::getInstance()->setBoolForKey("PowerupPresented", true);
-    }
+    });
 }
 
 void PowerupSpawner::addIconToQueue(PowerupIcon *icon, std::string name)
@@ -288,8 +295,63 @@ void PowerupSpawner::update(float delta)
     }
 }
 
-void PowerupSpawner::detectDeath(EventCustom *event)
+void PowerupSpawner::reset()
+{
+    stopAllActions();
+    removeAllChildren();
+    
+    for (PowerupIcon *icon : icons)
+    {
+        icon->removeFromParent();
+        icon->release();
+    }
+    icons.clear();
+    
+    spawnNumber = 0;
+    scheduleSpawn(16);
+}
+
+void PowerupSpawner::saveSnapshot(WorldSnapshot::Writer &writer)
+{
+    auto spawn = static_cast<ActionInterval*>(getActionByTag(SpawnActionTag));
+    writer.write(int32_t(spawnNumber));
+    writer.write(spawn ? spawn->getDuration() - spawn->getElapsed() : 16.0f);
+    
+    // The ones collected are still here while they disappear, but they don't fly anymore
+    uint8_t count = 0;
+    for (Node *child : _children)
+        if (child->getActionByTag(FlightActionTag)) count++;
+    
+    writer.write(count);
+    for (Node *child : _children)
+        if (child->getActionByTag(FlightActionTag))
+        {
+            writer.write(uint8_t(child->getTag()));
+            writer.write(child->getPosition());
+        }
+}
+
+bool PowerupSpawner::restoreSnapshot(WorldSnapshot::Reader &reader)
+{
+    spawnNumber = reader.read<int32_t>();
+    auto delay = reader.read<float>();
+    
+    stopActionByTag(SpawnActionTag);
+    scheduleSpawn(delay);
+    
+    int count = reader.read<uint8_t>();
+    while (count--)
+    {
+        int value = reader.read<uint8_t>();
+        auto position = reader.readVec2();
+        if (reader.isValid()) addPowerup(value, position);
+    }
+    
+    return reader.isValid();
+}
+
+void PowerupSpawner::detectDeath(const GameEvents::LifeUpdate &event)
 {
-    if (*static_cast<int*>(event->getUserData()) == 0)
+    if (event.health == 0)
         for (PowerupIcon *icon : icons) icon->collapse();
 }
\ No newline at end of file
@@ -10,6 +10,8 @@
 #define __SpaceExplorer__PowerupSpawner__
 
 #include "cocos2d.h"
+#include "GameEvents.h"
+#include "WorldSnapshot.h"
 
 class PowerupSpawner;
 
@@ -37,11 +39,15 @@ class PowerupSpawner : public cocos2d::Node
 {
     int spawnNumber;
     cocos2d::Vector<PowerupIcon*> icons;
-    cocos2d::EventListenerCustom* listener;
+    GameEvents::ListenerId listener;
     
     virtual bool init() override;
     virtual void update(float delta) override;
     void spawnPowerup();
+    void scheduleSpawn(float delay);
+    
+    // value is the roll that chose the powerup, which it keeps as its tag
+    void addPowerup(int value, cocos2d::Vec2 position);
     void addIconToQueue(PowerupIcon *icon, std::string name);
     
     virtual void onEnterTransitionDidFinish() override;
@@ -49,7 +55,15 @@ class PowerupSpawner : public cocos2d::Node
     virtual void onEnter() override;
     
 public:
-    void detectDeath(cocos2d::EventCustom *custom);
+    void detectDeath(const GameEvents::LifeUpdate &event);
+    
+    // Takes the powerups and icons away and starts counting to the first spawn again
+    void reset();
+    
+    // The countdown to the next powerup and the powerups still flying; the ones already collected, and what
+    // they're doing to the player, are left out
+    void saveSnapshot(WorldSnapshot::Writer &writer);
+    bool restoreSnapshot(WorldSnapshot::Reader &reader);
     
     virtual ~PowerupSpawner();
     CREATE_FUNC(PowerupSpawner);
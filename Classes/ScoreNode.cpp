@@ -102,12 +102,12 @@ bool ScoreNode::init(const Size &screenSize)
     
     playerDead = paused = false;
     
-    scoreUpdateListener = _eventDispatcher->addCustomEventListener("ScoreUpdate", CC_CALLBACK_1(ScoreNode::updateScore, this));
-    lifeUpdateListener = _eventDispatcher->addCustomEventListener("LifeUpdate", CC_CALLBACK_1(ScoreNode::lifeUpdate, this));
+    scoreUpdateListener = GameEvents::subscribe<GameEvents::ScoreUpdate>(CC_CALLBACK_1(ScoreNode::updateScore, this));
+    lifeUpdateListener = GameEvents::subscribe<GameEvents::LifeUpdate>(CC_CALLBACK_1(ScoreNode::lifeUpdate, this));
     
-    doubleScoreListener = _eventDispatcher->addCustomEventListener("TriggerDoubleScore", [this] (EventCustom *event)
+    doubleScoreListener = GameEvents::subscribe<GameEvents::DoubleScore>([this] (const GameEvents::DoubleScore &event)
     {
-        doubleScore = *static_cast<bool*>(event->getUserData());
+        doubleScore = event.enabled;
         updateMultiplierText(doubleScore);
     });
     
@@ -129,9 +129,9 @@ bool ScoreNode::init(const Size &screenSize)
 
 ScoreNode::~ScoreNode()
 {
-    _eventDispatcher->removeEventListener(scoreUpdateListener);
-    _eventDispatcher->removeEventListener(lifeUpdateListener);
-    _eventDispatcher->removeEventListener(doubleScoreListener);
+    GameEvents::unsubscribe<GameEvents::ScoreUpdate>(scoreUpdateListener);
+    GameEvents::unsubscribe<GameEvents::LifeUpdate>(lifeUpdateListener);
+    GameEvents::unsubscribe<GameEvents::DoubleScore>(doubleScoreListener);
 }
 
 void ScoreNode::onEnterTransitionDidFinish()
@@ -173,6 +173,9 @@ void ScoreNode::update(float delta)
     
     if (multiplierTime <= 0)
     {
+        // The points earned before the upgrade are worth the old multiplier
+        GameEvents::flush();
+        
         multiplier += MultiplierUpgradeStep;
         global_MaxMultiplier = MAX(global_MaxMultiplier, multiplier);
         multiplierTime = MultiplierUpgradeTime + 2*multiplier;
@@ -219,25 +222,25 @@ void ScoreNode::updateMultiplierText(bool createText)
     }
 }
 
-void ScoreNode::lifeUpdate(EventCustom *event)
+void ScoreNode::lifeUpdate(const GameEvents::LifeUpdate &event)
 {
-    if (*static_cast<int*>(event->getUserData()) >= 0)
+    if (event.health >= 0)
     {
         multiplier = 1;
         multiplierTime = MultiplierUpgradeTime;
         updateMultiplierText(false);
     }
     
-    if (*static_cast<int*>(event->getUserData()) == 0) playerDead = true;
+    if (event.health == 0) playerDead = true;
 }
 
-void ScoreNode::updateScore(EventCustom *event)
+void ScoreNode::updateScore(const GameEvents::ScoreUpdate &event)
 {
     if (playerDead) return;
     
     float realMultiplier = doubleScore ? 2*multiplier : multiplier;
     
-    long newScore = global_GameScore + realMultiplier * *static_cast<int*>(event->getUserData());
+    long newScore = global_GameScore + realMultiplier * event.points;
     long oldScore;
     
     if (!textUpdateAction || textUpdateAction->isDone())
@@ -297,3 +300,49 @@ void ScoreNode::resetScore()
     scoreText->setString("000000");
     updateMultiplierText(false);
 }
+
+void ScoreNode::restart()
+{
+    if (textUpdateAction)
+    {
+        scoreText->stopAction(textUpdateAction);
+        textUpdateAction->release();
+        textUpdateAction = nullptr;
+    }
+    
+    if (scoreTrackingText)
+    {
+        scoreTrackingText->removeFromParent();
+        scoreTrackingText = nullptr;
+    }
+    removeChildByName("MultiplierText");
+    
+    playerDead = doubleScore = false;
+    global_MaxMultiplier = 1;
+    multiplierTime = MultiplierUpgradeTime;
+    resetScore();
+    
+    ScoreManager::updateScoreTrackingArray();
+}
+
+void ScoreNode::saveSnapshot(WorldSnapshot::Writer &writer) const
+{
+    writer.write(int64_t(global_GameScore));
+    writer.write(multiplier);
+    writer.write(multiplierTime);
+    writer.write(global_MaxMultiplier);
+}
+
+bool ScoreNode::restoreSnapshot(WorldSnapshot::Reader &reader)
+{
+    auto score = reader.read<int64_t>();
+    multiplier = reader.read<float>();
+    multiplierTime = reader.read<float>();
+    global_MaxMultiplier = reader.read<float>();
+    if (!reader.isValid() || score < 0) return false;
+    
+    global_GameScore = score;
+    scoreText->setString(ulongToString(global_GameScore, 6));
+    updateMultiplierText(false);
+    return true;
+}
@@ -10,6 +10,8 @@
 #define __SpaceExplorer__ScoreNode__
 
 #include "cocos2d.h"
+#include "GameEvents.h"
+#include "WorldSnapshot.h"
 
 class TextUpdateAction : public cocos2d::ActionInterval
 {
@@ -27,7 +29,8 @@ public:
 class ScoreNode : public cocos2d::Node
 {
     cocos2d::Label *scoreText, *multiplierText, *scoreTrackingText;
-    cocos2d::EventListenerCustom *scoreUpdateListener, *lifeUpdateListener, *dummyListener, *doubleScoreListener;
+    cocos2d::EventListenerCustom *dummyListener;
+    GameEvents::ListenerId scoreUpdateListener, lifeUpdateListener, doubleScoreListener;
     
     bool doubleScore;
     float multiplier, multiplierTime;
@@ -35,8 +38,8 @@ class ScoreNode : public cocos2d::Node
     
     void computeTextPositions(const cocos2d::Size &size);
     void updateMultiplierText(bool createText = true);
-    void lifeUpdate(cocos2d::EventCustom *event);
-    void updateScore(cocos2d::EventCustom *event);
+    void lifeUpdate(const GameEvents::LifeUpdate &event);
+    void updateScore(const GameEvents::ScoreUpdate &event);
     void updateScoreTracking();
     int64_t nextTrackedScore;
     
@@ -52,6 +55,13 @@ public:
     virtual void update(float delta) override;
     void resetScore();
     
+    // Everything resetScore does, plus the state a game leaves behind (a dead player, a double score...)
+    void restart();
+    
+    // The score and the multiplier; a double score that's on is left out, along with the powerup
+    void saveSnapshot(WorldSnapshot::Writer &writer) const;
+    bool restoreSnapshot(WorldSnapshot::Reader &reader);
+    
     static ScoreNode *create(const cocos2d::Size &screenSize);
 
     virtual ~ScoreNode();
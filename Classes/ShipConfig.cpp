@@ -7,6 +7,7 @@
 //
 
 #include "ShipConfig.h"
+#include "Defaults.h"
 
 using namespace cocos2d;
 
@@ -32,6 +33,8 @@ void parseConfigValueVector(const ValueVector &configValueVector, std::vector<Sh
         {
             for (const Value &colValue : polygonListIt->second.asValueVector())
                 cfg.collisionList.push_back(PointFromString(colValue.asString()));
+            
+            cfg.collisionShape = PolygonShape::getOrCreate(cfg.collisionList.data(), (int)cfg.collisionList.size(), PlayerScale);
         }
         else
         {
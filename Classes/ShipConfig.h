@@ -12,6 +12,7 @@
 #include <string>
 #include <vector>
 #include "cocos2d.h"
+#include "PolygonShape.h"
 
 struct ShipConfig
 {
@@ -24,6 +25,7 @@ struct ShipConfig
     float collisionRadius;
     cocos2d::Vec2 collisionOffset;
     std::vector<cocos2d::Vec2> collisionList;
+    cocos2d::RefPtr<PolygonShape> collisionShape; // collisionList at the player's scale, built once on load
 };
 
 const ShipConfig &getShipConfig(unsigned long index);
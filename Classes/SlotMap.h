@@ -0,0 +1,137 @@
+//
+//  SlotMap.h
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#ifndef SlotMap_h
+#define SlotMap_h
+
+#include <cstddef>
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+// A handle to an element of a slot map; it's invalidated (and detected as such) once its element is erased
+struct SlotMapHandle
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+    
+    inline bool operator==(const SlotMapHandle &other) const { return index == other.index && generation == other.generation; }
+    inline bool operator!=(const SlotMapHandle &other) const { return !(*this == other); }
+    inline explicit operator bool() const { return index != UINT32_MAX; }
+};
+
+struct SlotMapNoColdData {};
+
+// Dense storage with stable, generation-checked handles. The elements are kept contiguous in two parallel
+// arrays, one for the fields read on every iteration (hot) and one for the rest (cold). Erasing moves the last
+// element onto the erased one, so iteration order is not preserved.
+template <typename Hot, typename Cold = SlotMapNoColdData>
+class SlotMap
+{
+    struct Slot { uint32_t dense; uint32_t generation; };
+    
+    std::vector<Hot> hotData;
+    std::vector<Cold> coldData;
+    std::vector<uint32_t> denseToSlot;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    
+    inline const Slot *findSlot(SlotMapHandle handle) const
+    {
+        if (handle.index >= slots.size()) return nullptr;
+        const Slot &slot = slots[handle.index];
+        return slot.generation == handle.generation && slot.dense != UINT32_MAX ? &slot : nullptr;
+    }
+
+public:
+    typedef SlotMapHandle Handle;
+    
+    inline SlotMapHandle insert(Hot &&hot, Cold cold = Cold())
+    {
+        uint32_t index;
+        if (freeSlots.empty())
+        {
+            index = (uint32_t)slots.size();
+            slots.push_back({ UINT32_MAX, 0 });
+        }
+        else
+        {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        
+        slots[index].dense = (uint32_t)hotData.size();
+        hotData.push_back(std::move(hot));
+        coldData.push_back(std::move(cold));
+        denseToSlot.push_back(index);
+        
+        SlotMapHandle handle;
+        handle.index = index;
+        handle.generation = slots[index].generation;
+        return handle;
+    }
+    
+    inline void eraseAt(size_t dense)
+    {
+        uint32_t slot = denseToSlot[dense];
+        size_t last = hotData.size()-1;
+        
+        if (dense != last)
+        {
+            hotData[dense] = std::move(hotData[last]);
+            coldData[dense] = std::move(coldData[last]);
+            denseToSlot[dense] = denseToSlot[last];
+            slots[denseToSlot[dense]].dense = (uint32_t)dense;
+        }
+        
+        hotData.pop_back();
+        coldData.pop_back();
+        denseToSlot.pop_back();
+        
+        slots[slot].dense = UINT32_MAX;
+        slots[slot].generation++;
+        freeSlots.push_back(slot);
+    }
+    
+    inline bool erase(SlotMapHandle handle)
+    {
+        auto slot = findSlot(handle);
+        if (!slot) return false;
+        eraseAt(slot->dense);
+        return true;
+    }
+    
+    inline void clear()
+    {
+        while (!hotData.empty()) eraseAt(hotData.size()-1);
+    }
+    
+    inline bool contains(SlotMapHandle handle) const { return findSlot(handle) != nullptr; }
+    
+    inline Hot *get(SlotMapHandle handle) { auto slot = findSlot(handle); return slot ? &hotData[slot->dense] : nullptr; }
+    inline Cold *getCold(SlotMapHandle handle) { auto slot = findSlot(handle); return slot ? &coldData[slot->dense] : nullptr; }
+    inline size_t denseIndex(SlotMapHandle handle) const { auto slot = findSlot(handle); return slot ? slot->dense : SIZE_MAX; }
+    
+    // Dense access, for linear iteration
+    inline size_t size() const { return hotData.size(); }
+    inline bool empty() const { return hotData.empty(); }
+    inline Hot &hot(size_t dense) { return hotData[dense]; }
+    inline const Hot &hot(size_t dense) const { return hotData[dense]; }
+    inline Cold &cold(size_t dense) { return coldData[dense]; }
+    inline const Cold &cold(size_t dense) const { return coldData[dense]; }
+    
+    inline SlotMapHandle handleAt(size_t dense) const
+    {
+        SlotMapHandle handle;
+        handle.index = denseToSlot[dense];
+        handle.generation = slots[handle.index].generation;
+        return handle;
+    }
+};
+
+#endif /* SlotMap_h */
@@ -48,7 +48,7 @@ bool TutorialNode::init(const Size &screenSize)
     touchListener->onTouchEnded = CC_CALLBACK_2(TutorialNode::tapScreen, this);
     
     _eventDispatcher->addEventListenerWithSceneGraphPriority(touchListener, this);
-    tutorialMessageListener = _eventDispatcher->addCustomEventListener("TutorialMessage", CC_CALLBACK_1(TutorialNode::pushMessage, this));
+    tutorialMessageListener = GameEvents::subscribe<GameEvents::TutorialMessage>(CC_CALLBACK_1(TutorialNode::pushMessage, this));
     
     setName("TutorialNode");
     scheduleUpdate();
@@ -58,7 +58,7 @@ bool TutorialNode::init(const Size &screenSize)
 
 TutorialNode::~TutorialNode()
 {
-    _eventDispatcher->removeEventListener(tutorialMessageListener);
+    GameEvents::unsubscribe<GameEvents::TutorialMessage>(tutorialMessageListener);
 }
 
 void TutorialNode::onEnterTransitionDidFinish()
@@ -79,10 +79,10 @@ void TutorialNode::onExitTransitionDidStart()
     recursivePause(this);
 }
 
-void TutorialNode::pushMessage(EventCustom *event)
+void TutorialNode::pushMessage(const GameEvents::TutorialMessage &event)
 {
     auto prevEmpty = messageQueue.empty();
-    messageQueue.push_back(*static_cast<std::string*>(event->getUserData()));
+    messageQueue.push_back(event.text);
     if (prevEmpty) processMessage();
 }
 
@@ -124,6 +124,15 @@ void TutorialNode::processMessage()
     }
 }
 
+void TutorialNode::clearMessages()
+{
+    stopAllActions();
+    messageQueue.clear();
+    queuedEvent.clear();
+    waitForInput = false;
+    setOpacity(0);
+}
+
 void TutorialNode::tapScreen(Touch *touch, Event *event)
 {
     if (waitForInput)
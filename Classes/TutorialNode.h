@@ -11,6 +11,7 @@
 
 #include "cocos2d.h"
 #include "ui/CocosGUI.h"
+#include "GameEvents.h"
 
 class TutorialNode : public cocos2d::ui::Text
 {
@@ -18,9 +19,9 @@ class TutorialNode : public cocos2d::ui::Text
     std::string queuedEvent;
     bool waitForInput;
     
-    cocos2d::EventListenerCustom *tutorialMessageListener;
+    GameEvents::ListenerId tutorialMessageListener;
     
-    void pushMessage(cocos2d::EventCustom* event);
+    void pushMessage(const GameEvents::TutorialMessage &event);
     void nextMessage();
     void processMessage();
     
@@ -33,6 +34,9 @@ public:
     virtual void onEnter();
     virtual void onExitTransitionDidStart();
     
+    // Drops the message being shown and the queued ones
+    void clearMessages();
+    
     static TutorialNode *create(const cocos2d::Size &screenSize);
     
     virtual ~TutorialNode();
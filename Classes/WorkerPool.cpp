@@ -0,0 +1,92 @@
+//
+//  WorkerPool.cpp
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int numWorkers) : nextJob(0)
+{
+    for (int i = 0; i < numWorkers; i++)
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wakeCondition.notify_all();
+    
+    for (auto &worker : workers) worker.join();
+}
+
+void WorkerPool::runJobs()
+{
+    for (;;)
+    {
+        int index = nextJob.fetch_add(1);
+        if (index >= jobCount) break;
+        (*currentJob)(index);
+    }
+}
+
+void WorkerPool::workerLoop()
+{
+    unsigned int seenGeneration = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    
+    for (;;)
+    {
+        wakeCondition.wait(lock, [&] { return quit || generation != seenGeneration; });
+        if (quit) return;
+        seenGeneration = generation;
+        
+        lock.unlock();
+        runJobs();
+        lock.lock();
+        
+        if (++finishedWorkers == (int)workers.size()) doneCondition.notify_one();
+    }
+}
+
+void WorkerPool::parallelFor(int count, const std::function<void(int)> &job)
+{
+    if (workers.empty() || count <= 1)
+    {
+        for (int i = 0; i < count; i++) job(i);
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentJob = &job;
+        jobCount = count;
+        nextJob = 0;
+        finishedWorkers = 0;
+        generation++;
+    }
+    wakeCondition.notify_all();
+    
+    runJobs();
+    
+    // Every worker has to go through this generation before returning, so none of them
+    // can still be looking at this job once the next one is set up
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this] { return finishedWorkers == (int)workers.size(); });
+    currentJob = nullptr;
+}
+
+WorkerPool &WorkerPool::getInstance()
+{
+    static WorkerPool pool([]
+    {
+        int numWorkers = (int)std::thread::hardware_concurrency() - 1;
+        return numWorkers < 1 ? 1 : numWorkers > MaxWorkers ? MaxWorkers : numWorkers;
+    }());
+    return pool;
+}
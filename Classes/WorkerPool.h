@@ -0,0 +1,59 @@
+//
+//  WorkerPool.h
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#ifndef WorkerPool_h
+#define WorkerPool_h
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// A small set of persistent threads for data-parallel work inside a frame. Jobs must not touch the
+// scene graph or anything else that isn't thread-safe; they're meant to read snapshots and write
+// to their own buffers
+class WorkerPool
+{
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeCondition, doneCondition;
+    
+    const std::function<void(int)> *currentJob = nullptr;
+    std::atomic<int> nextJob;
+    int jobCount = 0;
+    unsigned int generation = 0;
+    int finishedWorkers = 0;
+    bool quit = false;
+    
+    void runJobs();
+    void workerLoop();
+
+public:
+    explicit WorkerPool(int numWorkers);
+    ~WorkerPool();
+    
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool &operator=(const WorkerPool&) = delete;
+    
+    // Not counting the thread that calls parallelFor, which also runs jobs
+    inline int getWorkerCount() const { return (int)workers.size(); }
+    
+    // Runs job(i) for every i in [0, count), spread over the workers and the calling thread, and
+    // returns when all of them are done. Must only be called from one thread at a time
+    void parallelFor(int count, const std::function<void(int)> &job);
+    
+    // Waking more threads than this costs more than what they'd get through in a frame
+    static constexpr int MaxWorkers = 7;
+    
+    // Shared pool with one worker less than the number of cores (between 1 and MaxWorkers), created on first use
+    static WorkerPool &getInstance();
+};
+
+#endif /* WorkerPool_h */
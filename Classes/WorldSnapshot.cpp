@@ -0,0 +1,77 @@
+//
+//  WorldSnapshot.cpp
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#include "WorldSnapshot.h"
+
+using namespace cocos2d;
+
+namespace WorldSnapshot
+{
+    constexpr uint32_t Magic = 0x57455349; // "ISEW"
+    constexpr uint16_t Version = 1;
+    
+    static std::string getPath(const char *name)
+    {
+        return FileUtils::getInstance()->getWritablePath() + name;
+    }
+}
+
+void WorldSnapshot::writeHeader(Writer &writer, unsigned long ship, const Size &playfieldSize)
+{
+    writer.write(Magic);
+    writer.write(Version);
+    writer.write(uint8_t(ship));
+    writer.write(playfieldSize.width);
+    writer.write(playfieldSize.height);
+}
+
+bool WorldSnapshot::readHeader(Reader &reader, unsigned long &ship, Size &playfieldSize)
+{
+    if (reader.read<uint32_t>() != Magic || reader.read<uint16_t>() != Version)
+        return false;
+    
+    ship = reader.read<uint8_t>();
+    playfieldSize.width = reader.read<float>();
+    playfieldSize.height = reader.read<float>();
+    return reader.isValid();
+}
+
+bool WorldSnapshot::save(const Writer &writer)
+{
+    // Written aside and then renamed over the old one, so a process killed mid-write leaves the last good snapshot
+    Data data;
+    data.copy(writer.getBuffer().data(), writer.getBuffer().size());
+    
+    if (!FileUtils::getInstance()->writeDataToFile(data, getPath("snapshot.tmp")))
+        return false;
+    return FileUtils::getInstance()->renameFile(getPath("snapshot.tmp"), getPath("snapshot.bin"));
+}
+
+Data WorldSnapshot::load()
+{
+    auto path = getPath("snapshot.bin");
+    if (!FileUtils::getInstance()->isFileExist(path)) return Data::Null;
+    return FileUtils::getInstance()->getDataFromFile(path);
+}
+
+bool WorldSnapshot::peekShip(unsigned long &ship)
+{
+    auto data = load();
+    if (data.isNull()) return false;
+    
+    Reader reader(data.getBytes(), data.getSize());
+    Size playfieldSize;
+    return readHeader(reader, ship, playfieldSize);
+}
+
+void WorldSnapshot::discard()
+{
+    auto path = getPath("snapshot.bin");
+    if (FileUtils::getInstance()->isFileExist(path))
+        FileUtils::getInstance()->removeFile(path);
+}
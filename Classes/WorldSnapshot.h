@@ -0,0 +1,103 @@
+//
+//  WorldSnapshot.h
+//  SpaceExplorer
+//
+//  Created by agent on 17/10/26.
+//
+//
+
+#ifndef WorldSnapshot_h
+#define WorldSnapshot_h
+
+#include "cocos2d.h"
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// A game in progress, saved as a small binary file when it's paused or sent to the background, so it can be
+// resumed right away if the system closes the app meanwhile. Each node writes and reads back its own part
+// (see the saveSnapshot and restoreSnapshot methods), always in the same order, which GameScene drives
+namespace WorldSnapshot
+{
+    // Plain values, appended as their bytes in the device's own layout: a snapshot is only ever read back by the
+    // device that wrote it, and a version mismatch throws it away
+    class Writer
+    {
+        std::vector<unsigned char> buffer;
+    
+    public:
+        inline Writer() { buffer.reserve(4096); }
+        
+        template <typename T> inline void write(const T &value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written to a snapshot");
+            auto bytes = reinterpret_cast<const unsigned char*>(&value);
+            buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+        }
+        
+        inline void write(const cocos2d::Vec2 &value)
+        {
+            write(value.x);
+            write(value.y);
+        }
+        
+        inline const std::vector<unsigned char> &getBuffer() const { return buffer; }
+    };
+    
+    // Once a read goes past the end, it and every read after it return zero, and isValid turns false; so the
+    // readers can check it once, at the end of their part
+    class Reader
+    {
+        const unsigned char *data;
+        size_t size, position;
+        bool failed;
+    
+    public:
+        inline Reader(const unsigned char *data, size_t size) : data(data), size(size), position(0), failed(false) {}
+        
+        template <typename T> inline T read()
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be read from a snapshot");
+            T value;
+            
+            if (failed || size - position < sizeof(T))
+            {
+                failed = true;
+                std::memset(&value, 0, sizeof(T));
+                return value;
+            }
+            
+            std::memcpy(&value, data + position, sizeof(T));
+            position += sizeof(T);
+            return value;
+        }
+        
+        inline cocos2d::Vec2 readVec2()
+        {
+            float x = read<float>();
+            return cocos2d::Vec2(x, read<float>());
+        }
+        
+        inline bool isValid() const { return !failed; }
+        inline bool isAtEnd() const { return position == size; }
+    };
+    
+    // The header: which ship is being played, and the playfield it was played on, since the positions are relative
+    // to it. readHeader returns false if it isn't a snapshot of this version
+    void writeHeader(Writer &writer, unsigned long ship, const cocos2d::Size &playfieldSize);
+    bool readHeader(Reader &reader, unsigned long &ship, cocos2d::Size &playfieldSize);
+    
+    bool save(const Writer &writer);
+    
+    // The saved snapshot's bytes; empty if there's none
+    cocos2d::Data load();
+    
+    // Whether there's a snapshot, and which ship it was for, without reading it all
+    bool peekShip(unsigned long &ship);
+    
+    // The game it was saved from is over (or was left)
+    void discard();
+}
+
+#endif /* WorldSnapshot_h */